@@ -0,0 +1,200 @@
+#ifndef ANIMATION_HPP
+# define ANIMATION_HPP
+
+# include "commonInclude.hpp"
+# include "KeyCursor.hpp"
+# include <vector>
+
+/*
+	interpolated transform of one assimp channel at time (in ticks)
+	the channel must be valid (not empty and sorted keys), time is clamped on the keys
+*/
+void	sampleChannel(const aiNodeAnim *nodeAnim, float time, ChannelCursor &cursor, \
+	mat::Vec3 &translation, mat::Quaternion &rotation, mat::Vec3 &scaling);
+size_t	getKeysMemorySize(const aiNodeAnim *nodeAnim);  // size of the keys of the channel in bytes
+bool	isConstantChannel(const aiNodeAnim *nodeAnim);  // all the keys of each component are equal
+
+/*
+	error of a clip (baked, compressed) compared to its source channels
+	used for the max error allowed and for the max error measured
+*/
+struct ClipError {
+	float	translation = 0;  // distance
+	float	rotation = 0;  // angle in radians
+	float	scaling = 0;
+};
+
+/*
+	local transform of each track of a clip in SoA, to process all the tracks of a clip by simd batches
+	the component c of the track i is get(c)[i], the tracks are the animated nodes in the order of the skeleton
+*/
+class TrackPose {
+	public:
+		enum Component { TX, TY, TZ, RW, RX, RY, RZ, SX, SY, SZ, NB_COMPONENTS };
+
+		void		resize(u_int32_t nbTracks) { _nbTracks = nbTracks; _data.resize(NB_COMPONENTS * nbTracks); }
+		u_int32_t	getNbTracks() const { return _nbTracks; }
+		float		*get(int component) { return _data.data() + component * _nbTracks; }
+		const float	*get(int component) const { return _data.data() + component * _nbTracks; }
+		mat::QuaternionSoA	getRotations() { return mat::QuaternionSoA{get(RX), get(RY), get(RZ), get(RW)}; }
+		void		set(u_int32_t track, mat::Vec3 const &translation, mat::Quaternion const &rotation, \
+			mat::Vec3 const &scaling);
+
+	private:
+		u_int32_t			_nbTracks = 0;
+		std::vector<float>	_data;
+};
+
+/*
+	keys around the time of each track: the transform of a track is interpolated from -> to
+	with the factor of its translation, rotation and scaling (filled by KeyframeAnimation::findKeys)
+*/
+struct TrackKeys {
+	enum { TRANSLATION, ROTATION, SCALING };
+
+	TrackPose			from;
+	TrackPose			to;
+	std::vector<float>	steps;  // factor of the component c of the track i: steps[c * nbTracks + i]
+
+	void	resize(u_int32_t nbTracks);
+	// lerp of the translations and scalings, nlerp or slerp (ROTATION_NLERP) of the rotations, by simd batches
+	void	interpolate(TrackPose &out);
+};
+
+/*
+	keys of an animation copied from the assimp channels (same keys, same result as sampleChannel)
+	in SoA, all the tracks in one allocation (arena) aligned on 32 bytes:
+		for each track and each of translation, rotation, scaling: times[n] then x[n] y[n] z[n] (+ w[n])
+	each array starts on 32 bytes -> the key search reads contiguous floats (16 times per cache line
+	instead of 2 or 3 assimp keys) and the values of a key are read only once the key is found
+*/
+class KeyframeAnimation {
+	public:
+		KeyframeAnimation();
+		// channels: channel of each node (nullptr if the node is not animated)
+		KeyframeAnimation(const aiAnimation *animation, std::vector<const aiNodeAnim*> const &channels);
+		KeyframeAnimation(KeyframeAnimation const &src);
+		KeyframeAnimation(KeyframeAnimation &&src);
+		~KeyframeAnimation();
+
+		KeyframeAnimation &operator=(KeyframeAnimation const &rhs);
+		KeyframeAnimation &operator=(KeyframeAnimation &&rhs);
+
+		int			getTrack(u_int32_t node) const { return _nodeTracks[node]; }  // -1 if the node is not animated
+		size_t		getMemorySize() const;  // in bytes
+
+		// interpolated transform of a track at time (in ticks, clamped on the keys)
+		void		sample(float time, int track, ChannelCursor &cursor, mat::Vec3 &translation, \
+			mat::Quaternion &rotation, mat::Vec3 &scaling) const;
+		// keys around time of a track in keys (at the index track), to interpolate all the tracks at once
+		void		findKeys(float time, int track, ChannelCursor &cursor, TrackKeys &keys) const;
+
+	private:
+		enum { TRANSLATION, ROTATION, SCALING };
+		struct Track {
+			u_int32_t	offset[3];  // index in the arena of the times of translation, rotation, scaling
+			u_int32_t	nbKeys[3];
+			u_int32_t	stride[3];  // size of each array (nbKeys rounded to 8)
+		};
+
+		void		interpolateVec3(float time, const Track &track, int component, u_int32_t &cursor, \
+			mat::Vec3 &out) const;
+
+		std::vector<int>	_nodeTracks;
+		std::vector<Track>	_tracks;
+		u_int32_t			_size;  // floats in the arena
+		float				*_arena;
+};
+
+/*
+	animation resampled at a fixed rate when the model is loaded
+	sampling at a time is then a direct index + a lerp between 2 frames (no keys search)
+
+	the frames are stored in SoA: one array per component (TrackPose::Component), frame after frame
+		tx[frame * nbTracks + track] ...
+	so all the tracks of one frame are contiguous
+	there is one track per animated node, the tracks are in the order of the nodes
+*/
+class BakedAnimation {
+	public:
+		BakedAnimation();
+		// channels: channel of each node (nullptr if the node is not animated), rate in Hz
+		BakedAnimation(const aiAnimation *animation, std::vector<const aiNodeAnim*> const &channels, float rate);
+
+		int			getTrack(u_int32_t node) const { return _nodeTracks[node]; }  // -1 if the node is not animated
+		u_int32_t	getNbTracks() const { return _nbTracks; }
+		u_int32_t	getNbFrames() const { return _nbFrames; }
+		size_t		getMemorySize() const;  // in bytes
+		ClipError	getMaxError() const { return _maxError; }
+
+		// interpolated transform of a track at time (in ticks, clamped on the animation)
+		void		sample(float time, int track, mat::Vec3 &translation, mat::Quaternion &rotation, \
+			mat::Vec3 &scaling) const;
+		// all the tracks at once (pose is resized to the number of tracks), same result as sample
+		void		sampleTracks(float time, TrackPose &pose) const;
+
+	private:
+		void		setFrame(u_int32_t frame, int track, mat::Vec3 const &translation, \
+			mat::Quaternion rotation, mat::Vec3 const &scaling);
+
+		std::vector<int>	_nodeTracks;
+		u_int32_t			_nbTracks;
+		u_int32_t			_nbFrames;
+		float				_framesPerTick;  // 1 / duration of a frame (in ticks)
+		std::vector<float>	_data;  // the 10 components arrays: translation (3), rotation (w x y z), scaling (3)
+		ClipError			_maxError;
+};
+
+/*
+	key of a compressed clip (8 bytes)
+*/
+struct QuantizedKey {
+	u_int16_t	mTime;  // 0 -> 65535 on the animation duration
+	u_int16_t	value[3];  // translation / scaling: in the range of the track, rotation: smallest three
+};
+
+/*
+	animation compressed when the model is loaded
+	- the keys that the interpolation of the quantized keys reconstructs within the tolerance are removed,
+	  so getMaxError() includes the quantization (rotations: keys added where nlerp is too far from slerp)
+	- the rotations are quantized on 48 bits (smallest three: the largest component is
+	  rebuilt from the 3 others, each on 15 bits + 2 bits for the index of the largest)
+	- the translations and scalings are quantized on 16 bits in the range of their track
+	- the times are quantized on 16 bits on the animation duration
+	sampling uses the key cursors (like the assimp keys) and decodes only the 2 keys around time
+*/
+class CompressedAnimation {
+	public:
+		CompressedAnimation();
+		// channels: channel of each node (nullptr if the node is not animated)
+		CompressedAnimation(const aiAnimation *animation, std::vector<const aiNodeAnim*> const &channels, \
+			ClipError const &tolerance);
+
+		int			getTrack(u_int32_t node) const { return _nodeTracks[node]; }  // -1 if the node is not animated
+		size_t		getMemorySize() const;  // in bytes
+		float		getCompressionRatio() const;  // size of the source keys / compressed size
+		ClipError	getMaxError() const { return _maxError; }
+
+		// interpolated transform of a track at time (in ticks, clamped on the animation)
+		void		sample(float time, int track, ChannelCursor &cursor, mat::Vec3 &translation, \
+			mat::Quaternion &rotation, mat::Vec3 &scaling) const;
+
+	private:
+		struct Track {
+			u_int32_t	first[3];  // index in _keys of the first key of translation, rotation, scaling
+			u_int32_t	nbKeys[3];
+			float		min[2][3];  // range of translation and scaling
+			float		step[2][3];  // (max - min) / 65535
+		};
+		// translation (range 0) or scaling (range 1) of a key
+		static mat::Vec3	decodeVec3(Track const &track, QuantizedKey const &key, int range);
+
+		std::vector<int>			_nodeTracks;
+		std::vector<Track>			_tracks;
+		std::vector<QuantizedKey>	_keys;
+		float						_timeScale;  // ticks -> quantized time
+		size_t						_sourceSize;
+		ClipError					_maxError;
+};
+
+#endif
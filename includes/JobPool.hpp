@@ -0,0 +1,51 @@
+#ifndef JOBPOOL_HPP
+# define JOBPOOL_HPP
+
+# include <atomic>
+# include <condition_variable>
+# include <functional>
+# include <mutex>
+# include <sys/types.h>
+# include <thread>
+# include <vector>
+
+/*
+	pool of worker threads created once (no thread creation during the frames)
+	parallelFor(count, job) calls job(0) ... job(count - 1) on the workers and on the calling thread,
+	the jobs are taken one by one (the slow jobs do not block the others) and it returns when all are done
+
+	the jobs must not call OpenGL (the context is only current on the main thread)
+	and must not throw
+*/
+class JobPool {
+	public:
+		// nbWorkers: threads created in addition to the calling thread, 0 to run everything on the calling thread
+		explicit JobPool(u_int32_t nbWorkers);
+		virtual ~JobPool();
+
+		void		parallelFor(u_int32_t count, std::function<void(u_int32_t)> const &job);
+		u_int32_t	getNbWorkers() const;
+
+		static u_int32_t	defaultNbWorkers();  // one per core, minus the calling thread
+
+	private:
+		JobPool(JobPool const &src);  // not copyable (threads)
+		JobPool &operator=(JobPool const &rhs);
+
+		void		workerLoop();
+		void		runJobs();
+
+		std::vector<std::thread>	_workers;
+		std::mutex					_mutex;
+		std::condition_variable		_startCond;  // a new batch of jobs or the pool is stopped
+		std::condition_variable		_doneCond;  // all the workers finished the batch
+		u_int64_t					_batch;  // incremented for each parallelFor
+		u_int32_t					_nbBusyWorkers;  // workers that did not finish the current batch
+		bool						_stop;
+
+		std::function<void(u_int32_t)> const	*_job;
+		u_int32_t					_count;
+		std::atomic<u_int32_t>		_next;  // next job to run
+};
+
+#endif
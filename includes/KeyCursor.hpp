@@ -0,0 +1,92 @@
+#ifndef KEYCURSOR_HPP
+# define KEYCURSOR_HPP
+
+# include "commonInclude.hpp"
+# include <algorithm>
+
+# define KEY_CURSOR_STEPS 4  // type: int -> keys checked after the cursor before the binary search
+
+/*
+	last key found for each keys array of a channel (position, rotation, scaling)
+*/
+struct ChannelCursor {
+	u_int32_t	position = 0;
+	u_int32_t	rotation = 0;
+	u_int32_t	scaling = 0;
+};
+
+/*
+	time of a key: the keys are assimp keys (aiVectorKey, aiQuatKey...) or only the times (float)
+*/
+template<typename Key>
+inline float	keyTime(const Key &key) { return static_cast<float>(key.mTime); }
+inline float	keyTime(float time) { return time; }
+
+/*
+	find the key to interpolate in an array of animation keys (aiVectorKey, aiQuatKey, float times...)
+	-> first index i with time <= keyTime(keys[i + 1]) (the keys must be sorted by time)
+
+	cursor is the last index found for this array: when the animation is played forward,
+	the key is the same or one of the next ones -> O(1)
+	after a jump (loop, speed change, new animation) the key is found with a binary search -> O(log n)
+	return false if time is after the last key (cursor is not changed)
+*/
+template<typename Key>
+bool	findKey(float time, const Key *keys, u_int32_t nbKeys, u_int32_t &cursor) {
+	if (nbKeys < 2)
+		return false;
+
+	// keys[cursor] is before time -> check the cursor and the next keys
+	if (cursor < nbKeys - 1 && (cursor == 0 || time > keyTime(keys[cursor]))) {
+		for (u_int32_t i = cursor; i < nbKeys - 1 && i <= cursor + KEY_CURSOR_STEPS; ++i) {
+			if (time <= keyTime(keys[i + 1])) {
+				cursor = i;
+				return true;
+			}
+		}
+	}
+
+	const Key *next = std::lower_bound(keys + 1, keys + nbKeys, time, \
+		[](const Key &key, float t) { return keyTime(key) < t; });
+	if (next == keys + nbKeys)
+		return false;
+	cursor = next - keys - 1;
+	return true;
+}
+
+/*
+	interpolation factor (0 to 1) between keys[cursor] and keys[cursor + 1], never fails (nbKeys must be >= 2)
+	time is clamped on the first and the last keys
+*/
+template<typename Key>
+float	keyFactor(float time, const Key *keys, u_int32_t nbKeys, u_int32_t &cursor) {
+	if (time <= keyTime(keys[0])) {
+		cursor = 0;
+		return 0.0f;
+	}
+	if (!findKey(time, keys, nbKeys, cursor)) {
+		cursor = nbKeys - 2;
+		return 1.0f;
+	}
+	float deltaTime = keyTime(keys[cursor + 1]) - keyTime(keys[cursor]);
+	if (!(deltaTime > 0))
+		return 1.0f;
+	float factor = (time - keyTime(keys[cursor])) / deltaTime;
+	return std::min(std::max(factor, 0.0f), 1.0f);
+}
+
+/*
+	the keys can be used by keyFactor: at least one key and sorted times (no NaN)
+*/
+template<typename Key>
+bool	isValidKeys(const Key *keys, u_int32_t nbKeys) {
+	if (nbKeys == 0 || !keys)
+		return false;
+	for (u_int32_t i = 1; i < nbKeys; ++i) {
+		if (!(keyTime(keys[i]) >= keyTime(keys[i - 1])))
+			return false;
+	}
+	return true;
+}
+
+#endif
@@ -1,23 +1,37 @@
 #ifndef MODEL_HPP
 # define MODEL_HPP
 
-# include "Mesh.hpp"
-# include "Texture.hpp"
-# include <assimp/Importer.hpp>
-# include <assimp/scene.h>
-# include <assimp/postprocess.h>
+# include "ModelAsset.hpp"
+# include "Pose.hpp"
+# include "PoseCache.hpp"
 # include <array>
+# include <memory>
 
+/*
+	instance of a model file: its own transform, animation, time and bones
+	the loaded data (meshes, textures, skeleton, animations) is shared with the other instances
+	of the same file (see ModelAsset)
+*/
 class Model {
 	public:
 		struct BoneInfo {
-			mat::Mat4 boneOffset;
-			mat::Mat4 finalTransformation;
+			mat::Affine boneOffset;
+			mat::Affine finalTransformation;
 			BoneInfo() {
-				boneOffset = mat::Mat4();
-				finalTransformation = mat::Mat4();
+				boneOffset = mat::Affine();
+				finalTransformation = mat::Affine();
 			}
 		};
+		typedef ModelAsset::SkeletonNode	SkeletonNode;
+		typedef ModelAsset::AssimpError		AssimpError;
+		// level of detail of the animation, from the distance to the camera (see ANIMATION_LOD_*)
+		enum AnimationLod {
+			LOD_FULL,  // all the bones every frame
+			LOD_THROTTLE,  // all the bones every ANIMATION_LOD_THROTTLE_FRAMES frames
+			LOD_NO_LEAVES,  // LOD_THROTTLE without the leaf bones
+			LOD_FROZEN,  // no update
+			NB_LOD
+		};
 
         Model(const char *path, Shader &shader, Shader &cubeShader, \
 		float const &animationSpeed, float const &dtTime);
@@ -28,9 +42,10 @@ class Model {
 
 		Shader					&getShader() const;
 		Shader					&getCubeShader() const;
-		std::vector<Mesh>		getMeshes() const;
-		std::string				getDirectory() const;
-		std::vector<Texture>	getTexturesLoaded() const;
+		std::shared_ptr<const ModelAsset> const	&getAsset() const;
+		std::vector<Mesh> const	&getMeshes() const;
+		std::string const		&getDirectory() const;
+		std::vector<Texture> const	&getTexturesLoaded() const;
 
 		mat::Vec3				getMinPos() const;
 		mat::Vec3				getMaxPos() const;
@@ -46,88 +61,68 @@ class Model {
 		bool					&isDrawCube();
 		bool					isDrawCube() const;
 
-		std::map<std::string, int>	getBoneMap() const;
+		std::map<std::string, int> const	&getBoneMap() const;
 		std::array<BoneInfo, MAX_BONES>	getBoneInfo() const;
-		std::array<float, MAX_BONES * 16>	getBoneInfoUniform() const;
-		std::array<float, MAX_BONES * 3>	getBonePosUniform() const;
+		std::array<float, MAX_BONES * 12>	getBoneInfoUniform() const;
+		std::array<float, MAX_BONES * 3> const	&getBonePosUniform() const;
 		u_int32_t				getActBoneId() const;
-		mat::Mat4				getGlobalTransform() const;
-		mat::Mat4				getGlobalInverseTransform() const;
+		u_int32_t				getNbInvalidChannels() const;
+		AnimationLod			getAnimationLod() const;
+		u_int32_t				getNbEvaluatedNodes() const;
+		u_int32_t				getNbEvaluatedBones() const;
+		u_int32_t				getNbCachedBones() const;
+		mat::Affine				getGlobalTransform() const;
+		mat::Affine				getGlobalInverseTransform() const;
 		void					loadNextAnimation();
+		void					loadNextAdditiveAnimation();
+		int						getAdditiveAnimationId() const;  // -1 if no additive layer
 
 		u_int32_t				getCubeVbo() const;
 		u_int32_t				getCubeVao() const;
 
+		void		update(mat::Vec3 const &cameraPos, PoseCache *poseCache = nullptr);
 		void		draw();
 
-		static const float		_cubeData[];
-
-		class AssimpError : public std::exception {
-			public:
-				virtual const char* what() const throw();
-		};
-		class AnimationError : public AssimpError {
-			public:
-				AnimationError(std::string const &msg) : _msg(msg) {}
-				virtual const char * what() const throw() {
-					return _msg.c_str();
-				}
-			private:
-				std::string _msg;
-		};
 	private:
-		void					loadModel(std::string path);
-		void					processNode(aiNode *node, const aiScene *scene);
-		Mesh					processMesh(aiMesh *mesh, const aiScene *scene);
-		std::vector<Texture>	loadMaterialTextures(const aiScene *scene, aiMaterial *mat, aiTextureType type, TextureT textType);
-		void					setBonesTransform(float animationTime, aiNode *node, const aiScene *scene, mat::Mat4 parentTransform);
-		void					setBonesPos(aiNode *node, mat::Mat4 parentTransform);
-		const aiNodeAnim*		findNodeAnim(const aiAnimation* animation, const std::string nodeName);
-		void					calcInterpolatedPosition(mat::Vec3 &out, float animationTime, const aiNodeAnim* nodeAnim);
-		void					calcInterpolatedRotation(mat::Quaternion &out, float animationTime, const aiNodeAnim* nodeAnim);
-		void					calcInterpolatedScaling(mat::Vec3 &out, float animationTime, const aiNodeAnim* nodeAnim);
-		u_int32_t				findPosition(float animationTime, const aiNodeAnim* nodeAnim);
-		u_int32_t				findRotation(float animationTime, const aiNodeAnim* nodeAnim);
-		u_int32_t				findScaling(float animationTime, const aiNodeAnim* nodeAnim);
+		void					initInstance();
+		float					getAnimationTicks(const aiAnimation *animation, float animationTime) const;
+		AnimationLod			computeAnimationLod(mat::Vec3 const &cameraPos);
+		void					setCurAnimation(u_int32_t animationId);
+		void					evaluateBones(float timeOffset, bool skipLeaves, PoseCache *poseCache);
+		void					setBonesUniform();
 		void					sendBones(int shaderId);
 
-		void					updateMinMaxPos(mat::Vec3 pos);
-		void					calcModelMatrix();
-		void					sendCubeData();
-
 		Shader					&_shader;
 		Shader					&_cubeShader;
-		std::vector<Mesh>		_meshes;
-		std::string				_directory;
-		std::vector<Texture>	_texturesLoaded;
+		std::shared_ptr<const ModelAsset>	_asset;
 
-		mat::Vec3				_minPos;
-		mat::Vec3				_maxPos;
 		mat::Mat4				_model;  // position in real world
 		mat::Mat4				_modelScale;
 		float const				&_animationSpeed;
 		float					_animationTime;
 		float const				&_dtTime;
 
-		std::map<std::string, int>	_boneMap; // maps a bone name to its index
-		std::array<BoneInfo, MAX_BONES>	_boneInfo;
-		std::array<mat::Vec3, MAX_BONES> _bonePos;
-
-		// all datas ready to send to vertex shader (uniform mat4[MAX_BONES])
-		std::array<float, MAX_BONES * 16>	_boneInfoUniform;
-		std::array<float, MAX_BONES * 3>	_bonePosUniform;
-
-		u_int32_t				_actBoneId = 0;
-		mat::Mat4				_globalTransform;
-		mat::Mat4				_globalInverseTransform;
-		aiAnimation				*_curAnimation;
+		BonePalette				_bonePalette;
+		PoseWorkspace			_poseWorkspace;
+		BlendWorkspace			_blendWorkspace;  // crossfade and additive layer
+
+		// all datas ready to send to vertex shader (uniform mat3x4[MAX_BONES])
+		std::array<float, MAX_BONES * 12>	_boneInfoUniform;
+		// throttled LOD: bones interpolated from the palette displayed before the last update to the computed one
+		std::array<float, MAX_BONES * 12>	_lodBonesFrom;
+		std::array<float, MAX_BONES * 12>	_lodBonesTo;
+		u_int32_t				_lodFrame;  // frames since the last update of the bones (throttled LOD)
+		AnimationLod			_animationLod;
+		u_int32_t				_nbEvaluatedNodes;  // animated nodes sampled by the last update
+		u_int32_t				_nbEvaluatedBones;  // bones computed by the last update
+		u_int32_t				_nbCachedBones;  // bones copied from the static cache by the last update
+
+		const aiAnimation		*_curAnimation;
 		uint32_t				_curAnimationId;
+		int						_fadeAnimationId;  // animation faded out by the crossfade, -1 if no crossfade
+		float					_fadeTime;  // [ms] since the start of the crossfade
+		int						_additiveAnimationId;  // added to the current animation, -1 if no additive layer
 		bool					_isAnimated;
-		const aiScene			*_scene;
-		Assimp::Importer		_importer;
-
-		u_int32_t				_cubeVbo;
-		u_int32_t				_cubeVao;
 
 		bool					_drawMesh;
 		bool					_drawCube;
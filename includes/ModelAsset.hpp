@@ -0,0 +1,154 @@
+#ifndef MODELASSET_HPP
+# define MODELASSET_HPP
+
+# include "Mesh.hpp"
+# include "Texture.hpp"
+# include "Animation.hpp"
+# include <assimp/Importer.hpp>
+# include <assimp/scene.h>
+# include <assimp/postprocess.h>
+# include <array>
+# include <memory>
+# include <mutex>
+
+/*
+	everything loaded from a model file: meshes and their GPU buffers, textures, skeleton and animations
+	it is read only after the loading and shared by all the Model of the same file (see load)
+	the GPU resources are deleted with the last Model that uses the asset
+*/
+class ModelAsset {
+	public:
+		// node of the flattened skeleton (the nodes are stored parent before children, in pre-order)
+		struct SkeletonNode {
+			const aiNode	*node;  // only used at load time (name)
+			int				parent;  // index of the parent node, -1 for the root
+			int				boneIndex;  // index of the bone, -1 if the node is not a bone
+			mat::Affine		localTransform;  // used when the node is not animated
+			mat::Vec3		bindTranslation;  // localTransform decomposed, blended with the animated nodes
+			mat::Quaternion	bindRotation;  // (see evaluateBlendedPose)
+			mat::Vec3		bindScaling;
+			bool			isLeaf;  // no children, skipped by Model::LOD_NO_LEAVES
+		};
+		/*
+		nodes of an animation that do not move, computed at load time (see ANIMATION_STATIC_CACHE)
+		a node is constant if it is not animated or if all its keys are equal, and static if it is constant
+		and all its parents are static: its global transform and its bone never change
+		*/
+		struct StaticPose {
+			std::vector<char>			isConstant;  // for each node
+			std::vector<char>			isStatic;
+			std::vector<mat::Affine>	locals;  // local transform of each node (used for the constant ones)
+			std::vector<mat::Affine>	globals;  // global transform of each node (used for the static ones)
+			std::vector<int>			bones;  // the static bones
+			std::vector<mat::Affine>	palette;  // final transform of the static bones
+		};
+
+		/*
+		asset of the file at path, loaded only if no Model uses it yet (the cache is keyed by the path)
+		withGpu: create the meshes buffers and the textures, must be called on the OpenGL thread
+		without GPU (headless) the asset can only be used to evaluate poses (see Pose.hpp)
+		throw AssimpError if the file can not be loaded
+		*/
+		static std::shared_ptr<const ModelAsset>	load(std::string const &path, bool withGpu = true);
+		static u_int32_t	getNbLoadedAssets();
+
+		virtual ~ModelAsset();
+
+		std::string const					&getPath() const;
+		bool								hasGpu() const;
+		std::vector<Mesh> const				&getMeshes() const;
+		std::string const					&getDirectory() const;
+		std::vector<Texture> const			&getTexturesLoaded() const;
+		mat::Vec3							getMinPos() const;
+		mat::Vec3							getMaxPos() const;
+		mat::Mat4 const						&getModelScale() const;
+		std::map<std::string, int> const	&getBoneMap() const;
+		mat::Affine const					&getBoneOffset(u_int32_t boneIndex) const;
+		std::array<float, MAX_BONES * 3> const	&getBonePosUniform() const;
+		u_int32_t							getActBoneId() const;
+		u_int32_t							getNbInvalidChannels() const;
+		mat::Affine const					&getGlobalTransform() const;
+		mat::Affine const					&getGlobalInverseTransform() const;
+		std::vector<SkeletonNode> const		&getSkeleton() const;
+		// nodes of the skeleton sorted by depth: the level l is getLevelNodes()[getLevelStarts()[l]] to
+		// getLevelNodes()[getLevelStarts()[l + 1] - 1] (the nodes of a level do not depend on each other)
+		std::vector<u_int32_t> const		&getLevelNodes() const;
+		std::vector<u_int32_t> const		&getLevelStarts() const;  // nb levels + 1 elements
+		bool								isAnimated() const;
+		u_int32_t							getNbAnimations() const;
+		const aiAnimation					*getAnimation(u_int32_t animationId) const;
+		// channel of each node of the skeleton in the animation, nullptr if the node is not animated
+		std::vector<const aiNodeAnim*> const	&getNodeChannels(u_int32_t animationId) const;
+		const BakedAnimation				*getBakedAnimation(u_int32_t animationId) const;  // nullptr if not baked
+		const CompressedAnimation			*getCompressedAnimation(u_int32_t animationId) const;  // nullptr if not compressed
+		const KeyframeAnimation				*getKeyframeAnimation(u_int32_t animationId) const;  // nullptr if baked or compressed
+		const StaticPose					*getStaticPose(u_int32_t animationId) const;  // nullptr if no cache
+		u_int32_t							getCubeVbo() const;
+		u_int32_t							getCubeVao() const;
+
+		static const mat::Matrix<36, 8>	_cubeData;
+
+		class AssimpError : public std::exception {
+			public:
+				virtual const char* what() const throw();
+		};
+	private:
+		ModelAsset(std::string const &path, bool withGpu);
+		ModelAsset(ModelAsset const &src);  // not copyable (GPU resources)
+		ModelAsset &operator=(ModelAsset const &rhs);
+
+		void					loadModel(std::string const &path);
+		void					processNode(aiNode *node, const aiScene *scene);
+		Mesh					processMesh(aiMesh *mesh, const aiScene *scene);
+		std::vector<Texture>	loadMaterialTextures(const aiScene *scene, aiMaterial *mat, aiTextureType type, TextureT textType);
+		void					loadSkeleton(const aiNode *node, int parent);
+		void					sortSkeletonLevels();
+		const aiNodeAnim*		findNodeAnim(const aiAnimation* animation, const std::string nodeName) const;
+		void					loadNodeChannels(const aiAnimation *animation, std::vector<const aiNodeAnim*> &channels) const;
+		void					bakeAnimations();
+		void					compressAnimations();
+		void					loadKeyframeAnimations();
+		void					loadStaticPoses();
+		static bool				isValidChannel(const aiNodeAnim *nodeAnim);
+		void					setBonesPos();
+		void					updateMinMaxPos(const mat::Vec3Array &positions);
+		void					calcModelScale();
+		void					sendCubeData();
+
+		std::string				_path;
+		bool					_withGpu;
+		std::vector<Mesh>		_meshes;
+		std::string				_directory;
+		std::vector<Texture>	_texturesLoaded;
+
+		mat::Vec3				_minPos;
+		mat::Vec3				_maxPos;
+		mat::Mat4				_modelScale;  // scale and center the model in a cube of size 2
+
+		std::map<std::string, int>	_boneMap; // maps a bone name to its index
+		std::array<mat::Affine, MAX_BONES>	_boneOffsets;
+		std::array<float, MAX_BONES * 3>	_bonePosUniform;  // bind pose position of each bone
+		u_int32_t				_actBoneId = 0;
+
+		mat::Affine				_globalTransform;
+		mat::Affine				_globalInverseTransform;
+		std::vector<SkeletonNode>		_skeleton;
+		std::vector<u_int32_t>	_levelNodes;
+		std::vector<u_int32_t>	_levelStarts;
+		std::vector<std::vector<const aiNodeAnim*> >	_nodeChannels;  // one table per animation
+		u_int32_t				_nbInvalidChannels;  // channels of all the animations replaced by the bind pose
+		std::vector<BakedAnimation>		_bakedAnimations;  // one per animation, empty if ANIMATION_BAKE_RATE is 0
+		std::vector<CompressedAnimation>	_compressedAnimations;  // one per animation, empty if no compression
+		std::vector<KeyframeAnimation>	_keyframeAnimations;  // one per animation, empty if baked or compressed
+		std::vector<StaticPose>			_staticPoses;  // one per animation, empty if ANIMATION_STATIC_CACHE is false
+		const aiScene			*_scene;
+		Assimp::Importer		_importer;
+
+		u_int32_t				_cubeVbo;
+		u_int32_t				_cubeVao;
+
+		static std::map<std::string, std::weak_ptr<const ModelAsset> >	_cache;
+		static std::mutex		_cacheMutex;
+};
+
+#endif
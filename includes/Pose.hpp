@@ -0,0 +1,135 @@
+#ifndef POSE_HPP
+# define POSE_HPP
+
+# include "ModelAsset.hpp"
+# include <array>
+# include <utility>
+# include <vector>
+
+// final transform of each bone (globalInverse * node global transform * bone offset), read by the shader
+typedef std::array<mat::Affine, MAX_BONES>	BonePalette;
+
+/*
+	memory reused by evaluatePose between two calls (one per instance or per thread)
+	the key cursors only make the keys search faster: the pose does not depend on them
+	the tables point in the buffers of the workspace -> a copy is an empty workspace
+*/
+struct PoseWorkspace {
+	const ModelAsset				*asset = nullptr;  // the workspace is reset when the asset
+	u_int32_t						animationId = 0;  // or the animation changes
+	std::vector<ChannelCursor>		cursors;  // last keys used by each node
+	std::vector<mat::Affine>		nodeTransforms;  // global transform of each node of the skeleton
+
+	// batch evaluation (evaluatePose)
+	std::vector<u_int32_t>			trackNodes;  // node of each track (animated node) of the animation
+	std::vector<int>				nodeTracks;  // track of each node, -1 if the node is not animated
+	TrackPose						trackPose;  // local transform of each track
+	TrackKeys						trackKeys;  // keys around the time (KeyframeAnimation)
+	std::vector<mat::Affine>		localTransforms;  // local transform of each animated node
+	std::vector<mat::Affine*>		trackLocals;  // in localTransforms, for each track
+	// tracks evaluated: all except the constant ones (ModelAsset::StaticPose), by runs [first, end)
+	std::vector<std::pair<u_int32_t, u_int32_t> >	trackRuns;
+	u_int32_t						nbRunTracks = 0;
+	u_int32_t						nbRunLeafTracks = 0;  // tracks of leaf nodes (skipLeaves)
+	// the nodes evaluated (not static) in the order of the levels (see ModelAsset::getLevelNodes)
+	// global = parent * local, the parents and the locals can be in the StaticPose
+	std::vector<u_int32_t>			levelNodes;
+	std::vector<u_int32_t>			levelStarts;
+	std::vector<const mat::Affine*>	levelParents;
+	std::vector<const mat::Affine*>	levelLocals;  // localTransforms or the bind pose of the skeleton
+	std::vector<mat::Affine*>		levelGlobals;
+	int								levelSkipLeaves = -1;  // skipLeaves of levelLocals
+	// the bones evaluated: palette = (globalInverse * global) * offset
+	std::vector<const mat::Affine*>	boneInverses;
+	std::vector<const mat::Affine*>	boneGlobals;
+	std::vector<const mat::Affine*>	boneOffsets;
+	std::vector<mat::Affine>		boneTransforms;  // globalInverse * global
+	std::vector<mat::Affine*>		boneTmp;  // in boneTransforms
+	std::vector<mat::Affine*>		boneOut;  // in the palette, set at each evaluation
+	std::vector<int>				boneIndexes;
+	u_int32_t						nbCachedBones = 0;  // bones of the last evaluation copied from the StaticPose
+	mat::Affine						globalTransform;  // copies of the asset transforms
+	mat::Affine						globalInverseTransform;
+
+	PoseWorkspace() {}
+	PoseWorkspace(PoseWorkspace const &) {}
+	PoseWorkspace &operator=(PoseWorkspace const &) { asset = nullptr; return *this; }
+};
+
+/*
+	pose of an animation of an asset at time (in ticks, clamped on the animation)
+	-> the transform of each bone of the asset in palette (the other entries are not changed)
+	uses the compressed, baked or keyframe clip of the animation (see ModelAsset)
+	skipLeaves: the leaf nodes keep their bind pose (LOD), except the static ones (cached)
+
+	the whole skeleton is evaluated by simd batches:
+	- the local transform of all the tracks in SoA (TrackPose): one lerp per component for the baked clips,
+	  keys search then batched lerp / slerp for the keyframe clips, node by node for the other clips
+	- the local matrices 4 by 4 (mat::composeBatch)
+	- the global transforms level by level, the nodes of a level are independent (mat::mulBatch)
+	- the palette 4 bones by 4
+	with ANIMATION_STATIC_CACHE, the static nodes and the constant tracks are not evaluated:
+	their transforms are copied from the StaticPose of the animation
+	evaluatePoseScalar is the reference: the same evaluation node by node, without cache
+	the results differ only by the rounding of the quaternions normalizations
+
+	no hidden state: only workspace and palette are written, so it can be called from any thread
+	at the same time (one workspace each) and without OpenGL context
+	no allocation once the workspace is used with the asset (no exception, the asset is valid)
+	return the number of animated nodes sampled (the bones copied from the cache are in workspace.nbCachedBones)
+*/
+u_int32_t	evaluatePose(ModelAsset const &asset, u_int32_t animationId, float time, PoseWorkspace &workspace, \
+	BonePalette &palette, bool skipLeaves = false);
+u_int32_t	evaluatePoseScalar(ModelAsset const &asset, u_int32_t animationId, float time, \
+	PoseWorkspace &workspace, BonePalette &palette, bool skipLeaves = false);
+
+// one clip of a blended pose (see evaluateBlendedPose)
+struct PoseLayer {
+	u_int32_t	animationId;
+	float		time;  // in ticks of the animation
+	float		weight;  // 0 (no effect) to 1, clamped
+	bool		additive;  // adds the difference between the clip and its first pose to the layers below
+};
+
+/*
+	memory reused by evaluateBlendedPose between two calls (one per instance or per thread)
+	it is reset when the asset, the animations or the additive flags of the layers change
+	a copy is an empty workspace (see PoseWorkspace)
+*/
+struct BlendWorkspace {
+	const ModelAsset				*asset = nullptr;
+	std::vector<u_int32_t>			animationIds;  // of the layers
+	std::vector<char>				additives;
+	std::vector<PoseWorkspace>		layers;  // sampling of the clip of each layer (all its tracks)
+	std::vector<std::vector<u_int32_t> >	layerTracks;  // track of the blended pose of each track of a layer
+	std::vector<TrackPose>			layerPoses;  // pose of each layer on the tracks of the blended pose (if the
+	// clip does not animate all of them, else it is the trackPose of the layer)
+	std::vector<TrackPose>			referencePoses;  // first pose of the additive layers (inverted rotation)
+	TrackPose						bindPose;  // on the tracks of the blended pose
+	TrackPose						identity;
+	TrackPose						deltas;  // rotations of an additive layer
+	std::vector<float>				weights;  // weight of the current layer for each track (batch steps)
+	PoseWorkspace					blended;  // the tracks are the nodes animated by at least one layer
+
+	BlendWorkspace() {}
+	BlendWorkspace(BlendWorkspace const &) {}
+	BlendWorkspace &operator=(BlendWorkspace const &) { asset = nullptr; return *this; }
+};
+
+/*
+	pose of several clips of an asset blended (crossfade, layers): same result as evaluatePose for one layer
+	(without the static cache)
+	the first layer is the base pose (its weight and additive are not used), each next layer is blended
+	on the pose of the layers below: lerp (nlerp for the rotations) by weight, or added by weight
+	(nlerp is not at constant speed in the weight, invisible in a crossfade, and much faster than slerp)
+	the nodes not animated by a layer use their bind pose in this layer
+
+	the clips are sampled in SoA (TrackPose) and blended by simd batches on the tracks, then the local,
+	global and bone transforms are computed once: N clips cost N samplings, not N poses
+	same threading and allocation rules as evaluatePose (the layers must not change at each call)
+	nbLayers >= 1, return the number of animated nodes sampled in all the layers
+*/
+u_int32_t	evaluateBlendedPose(ModelAsset const &asset, const PoseLayer *layers, u_int32_t nbLayers, \
+	BlendWorkspace &workspace, BonePalette &palette, bool skipLeaves = false);
+
+#endif
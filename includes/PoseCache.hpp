@@ -0,0 +1,60 @@
+#ifndef POSECACHE_HPP
+# define POSECACHE_HPP
+
+# include "Pose.hpp"
+# include <condition_variable>
+# include <map>
+# include <memory>
+# include <mutex>
+# include <tuple>
+
+/*
+	poses shared by the instances that play the same animation of the same asset at about the same time
+	the time is quantized by step (ms): all the instances in a time bucket use the palette evaluated
+	by the first one (the others wait for it if it is not finished)
+	a pose is kept while it is used: the next frames reuse it until the instances leave its bucket
+
+	getPose can be called from any thread during a frame (see JobPool), newFrame between the frames
+*/
+class PoseCache {
+	public:
+		explicit PoseCache(float step);
+		virtual ~PoseCache();
+
+		/*
+		evaluatePose through the cache: the time (ticks) is rounded down to the bucket start
+		hit: the palette is copied from the pose of another instance, workspace is not used
+		return the number of animated nodes sampled (0 on a hit)
+		*/
+		u_int32_t	getPose(std::shared_ptr<const ModelAsset> const &asset, u_int32_t animationId, float ticks, \
+			bool skipLeaves, PoseWorkspace &workspace, BonePalette &palette, bool &hit);
+		void		newFrame();  // remove the poses not used by the last frame and reset the counters
+
+		float		getStep() const;
+		u_int32_t	getNbPoses() const;
+		u_int32_t	getNbRequests() const;  // getPose calls since newFrame
+		u_int32_t	getNbHits() const;
+
+	private:
+		PoseCache(PoseCache const &src);  // not copyable (mutex)
+		PoseCache &operator=(PoseCache const &rhs);
+
+		// asset, animation, time bucket, skipLeaves
+		typedef std::tuple<const ModelAsset*, u_int32_t, int64_t, bool>	Key;
+		struct Entry {
+			std::weak_ptr<const ModelAsset>	asset;  // expired: the address can be used by another asset
+			BonePalette						palette;
+			u_int64_t						lastFrame;  // last frame that used the pose
+			bool							ready;  // palette evaluated
+		};
+
+		float						_step;
+		std::map<Key, Entry>		_entries;
+		mutable std::mutex			_mutex;
+		std::condition_variable		_readyCond;  // a palette is evaluated
+		u_int64_t					_frame;
+		u_int32_t					_nbRequests;
+		u_int32_t					_nbHits;
+};
+
+#endif
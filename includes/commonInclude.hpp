@@ -12,6 +12,28 @@
 
 # define NUM_BONES_PER_VERTEX 4 // type: int -> number of bones per vertex
 # define MAX_BONES 100 // maximum bones on the model
+// use nlerp instead of slerp to interpolate the bones rotations (faster, no trigonometry)
+# define ROTATION_NLERP false  // type: bool -> enable / disable nlerp
+// resample the animations at a fixed rate when the model is loaded (no keys search during the animation)
+# define ANIMATION_BAKE_RATE 30  // [Hz] type: float -> rate of the baked animations, 0 to use the keys (KeyframeAnimation)
+// compress the animations when the model is loaded (used instead of the baked animations)
+# define ANIMATION_COMPRESSION false  // type: bool -> enable / disable the animations compression
+// max error of the compression: rotation in radians, scaling, translation relative to the model size
+# define ANIMATION_COMPRESSION_TOLERANCE 0.001f  // type: float
+// compute once per animation the nodes that do not move (constant keys), they are copied at each frame
+# define ANIMATION_STATIC_CACHE true  // type: bool -> enable / disable the static nodes cache
+// the instances of an asset that play the same animation in the same time bucket share one pose (see PoseCache)
+# define ANIMATION_POSE_CACHE_STEP 5.0f  // [ms] type: float -> size of the time buckets, 0 to disable the cache
+// blend the animations (see evaluateBlendedPose)
+# define ANIMATION_CROSSFADE_TIME 300.0f  // [ms] type: float -> crossfade to the next animation, 0 to switch instantly
+# define ANIMATION_ADDITIVE_WEIGHT 0.5f  // type: float -> weight of the additive animation layer (0 to 1)
+// animation LOD: the distances are from the camera to the model center, in model sizes
+# define ANIMATION_LOD true  // type: bool -> enable / disable the animation LOD
+// from this distance the bones are computed every ANIMATION_LOD_THROTTLE_FRAMES frames (interpolated between)
+# define ANIMATION_LOD_THROTTLE_DISTANCE 8.0f  // type: float
+# define ANIMATION_LOD_THROTTLE_FRAMES 3  // type: int -> >= 1
+# define ANIMATION_LOD_LEAVES_DISTANCE 16.0f  // type: float -> from this distance the leaf bones keep their bind pose
+# define ANIMATION_LOD_FREEZE_DISTANCE 40.0f  // type: float -> from this distance the animation is paused
 
 # define GLFW_INCLUDE_GLCOREARB
 # include <GLFW/glfw3.h>
@@ -21,12 +43,17 @@
 # include <assimp/scene.h>
 # include "Matrix.hpp"
 # include "Quaternion.hpp"
+# include "Affine.hpp"
+# include "MatrixExpr.hpp"
+# include "MatrixTemplate.hpp"
+# include "Vec3Array.hpp"
+# include "FastMath.hpp"
 
 /* matrix conversion */
 aiMatrix4x4 mat4ToAi(mat::Mat4 mat);
-mat::Mat4 aiToMat4(aiMatrix4x4& in_mat);
+mat::Mat4 aiToMat4(const aiMatrix4x4& in_mat);
 aiQuaternion quatToAi(mat::Quaternion quat);
-mat::Quaternion aiToQuat(aiQuaternion& in_quat);
+mat::Quaternion aiToQuat(const aiQuaternion& in_quat);
 mat::Vec3 aiToVec3(aiVector3D v);
 aiVector3D vec3ToAi(mat::Vec3 v);
 
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Matrix.hpp"
+#include "Quaternion.hpp"
+
+namespace mat {
+	/*
+	affine transformation stored as the 3 first lines of a Mat4 (the last one is always 0 0 0 1)
+	| r00 r01 r02 tx |
+	| r10 r11 r12 ty |
+	| r20 r21 r22 tz |
+	the data are ready to be sent with glUniformMatrix3x4fv(loc, n, GL_FALSE, data)
+	and used in the shader as: vec4(pos, 1.0) * bones[id]
+	*/
+	class Affine {
+		public:
+			Affine();  // identity
+			explicit Affine(const Mat4 &m);  // the last line of m is ignored
+			Affine(const Vec3 &translation, const Quaternion &rotation, const Vec3 &scale);  // T * R * S
+
+			const float *getData() const { return _data; }
+			float *getData() { return _data; }
+			float &get(int ln, int col) { return _data[ln * 4 + col]; }
+			const float &get(int ln, int col) const { return _data[ln * 4 + col]; }
+			Vec3 getTranslation() const { return Vec3(_data[3], _data[7], _data[11]); }
+
+			Affine inverse() const;  // throw std::invalid_argument if the matrix is not invertible
+			Mat4 toMat4() const;
+			Vec3 transformPoint(const Vec3 &p) const;  // apply rotation, scale and translation
+			Vec3 transformVector(const Vec3 &v) const;  // apply only rotation and scale
+
+			/* operators */
+			friend std::ostream &operator<<(std::ostream &out, const Affine &m);
+			friend Affine operator*(const Affine &m, const Affine &other);
+			friend bool operator==(const Affine &m, const Affine &other);
+			Affine &operator*=(const Affine &other);  // this = this * other
+			explicit operator float*() const { return const_cast<float*>(_data); }
+
+			// operator [][] -> return a pointer on the line
+			float *operator[](int line) { return _data + line * 4; }
+			const float *operator[](int line) const { return _data + line * 4; }
+
+		protected:
+			alignas(16) float _data[12];
+		private:
+	};
+
+	/*
+	batch operations on matrices given by pointers (they can be anywhere, ex: the nodes of a skeleton)
+	the matrices are processed 4 by 4 in SoA (one register per coefficient, transposed at load and store)
+	with the same operations as the single ones
+	mulBatch     -> *out[i] = *a[i] * *b[i] (out[i] can be a[i] or b[i])
+	composeBatch -> *out[i] = T * R * S of the translation, rotation and scale i (see Affine(T, R, S))
+	*/
+	void mulBatch(const Affine *const *a, const Affine *const *b, Affine *const *out, int count);
+	void composeBatch(const float *const translations[3], const QuaternionSoA &rotations, \
+		const float *const scales[3], Affine *const *out, int count);
+}
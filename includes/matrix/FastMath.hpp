@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "MatrixSimd.hpp"
+
+#if MAT_SIMD >= MAT_SIMD_SSE
+	#include <immintrin.h>
+#endif
+
+/*
+fast math mode of the matrix library, chosen at compile time:
+	MAT_FAST_MATH 0 -> std:: functions (default)
+	MAT_FAST_MATH 1 -> approximations of mat::fast (ex: make SIMD_FLAGS=-DMAT_FAST_MATH=1)
+the matrix code calls mat::math:: so it follows the mode
+the errors below are the max errors measured on the whole range (float)
+*/
+#ifndef MAT_FAST_MATH
+	#define MAT_FAST_MATH 0
+#endif
+
+namespace mat {
+	namespace fast {
+		const float PI = 3.14159265358979f;
+		const float HALF_PI = 1.57079632679490f;
+		const float TWO_PI = 6.28318530717959f;
+
+		/*
+		1 / sqrt(x) -> relative error < 5e-7 with sse, < 5e-6 without
+		sse: hardware estimation (12 bits) + 1 newton step
+		else: bit trick estimation + 2 newton steps
+		*/
+		inline float invSqrt(float x) {
+		#if MAT_SIMD >= MAT_SIMD_SSE
+			float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+			return y * (1.5f - 0.5f * x * y * y);
+		#else
+			float y;
+			uint32_t i;
+			memcpy(&i, &x, sizeof(i));
+			i = 0x5f3759df - (i >> 1);
+			memcpy(&y, &i, sizeof(y));
+			y = y * (1.5f - 0.5f * x * y * y);
+			return y * (1.5f - 0.5f * x * y * y);
+		#endif
+		}
+
+		/*
+		sin(x) -> absolute error < 3e-7 on [-2pi, 2pi], < 1e-5 for |x| < 100 (the range reduction loses precision)
+		reduced to [-pi/2, pi/2] then taylor polynomial up to x^11 (last term error: 6e-8)
+		*/
+		inline float sin(float x) {
+			if (x > HALF_PI || x < -HALF_PI) {  // the angles of the slerp are already in [0, pi/2]
+				float turns = x * (1 / TWO_PI);
+				x -= TWO_PI * static_cast<float>(static_cast<int>(turns + ((turns < 0) ? -0.5f : 0.5f)));  // [-pi, pi]
+				if (x > HALF_PI)
+					x = PI - x;
+				else if (x < -HALF_PI)
+					x = -PI - x;
+			}
+			float x2 = x * x;
+			return x * (1.0f + x2 * (-1.6666667e-1f + x2 * (8.3333333e-3f + x2 * (-1.9841270e-4f \
+				+ x2 * (2.7557319e-6f + x2 * -2.5052108e-8f)))));
+		}
+		inline float cos(float x) { return sin(x + HALF_PI); }  // same error as sin
+
+		/*
+		acos(x) -> absolute error < 5e-7 on [-1, 1]
+		polynomial of Abramowitz and Stegun (4.4.46): acos(x) = sqrt(1 - x) * p(x) for x in [0, 1]
+		*/
+		inline float acos(float x) {
+			float ax = std::fabs(x);
+			float p = -1.2624911e-3f;
+			p = p * ax + 6.6700901e-3f;
+			p = p * ax - 1.70881256e-2f;
+			p = p * ax + 3.08918810e-2f;
+			p = p * ax - 5.01743046e-2f;
+			p = p * ax + 8.89789874e-2f;
+			p = p * ax - 2.145988016e-1f;
+			p = p * ax + 1.5707963050f;
+			p *= std::sqrt(1.0f - ax);
+			return (x < 0) ? PI - p : p;
+		}
+	}
+
+	/*
+	functions used by the matrix library (follow MAT_FAST_MATH)
+	*/
+	namespace math {
+		inline float invSqrt(float x) {
+		#if MAT_FAST_MATH
+			return fast::invSqrt(x);
+		#else
+			return 1 / std::sqrt(x);
+		#endif
+		}
+		inline float sin(float x) {
+		#if MAT_FAST_MATH
+			return fast::sin(x);
+		#else
+			return std::sin(x);
+		#endif
+		}
+		inline float cos(float x) {
+		#if MAT_FAST_MATH
+			return fast::cos(x);
+		#else
+			return std::cos(x);
+		#endif
+		}
+		inline float acos(float x) {
+		#if MAT_FAST_MATH
+			return fast::acos(x);
+		#else
+			return std::acos(x);
+		#endif
+		}
+	}
+}
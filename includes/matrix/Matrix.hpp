@@ -19,6 +19,7 @@ namespace mat {
 			BaseMat(int size);  // init with identity matrix
 			BaseMat(int lns, int cols, std::vector<float> data);  // init with a copy of data
 			BaseMat(const BaseMat &m);
+			BaseMat(BaseMat &&m);  // steal the data of m (m is left empty)
 			~BaseMat();
 
 			void setLns(int lns);  // set number of lines
@@ -34,13 +35,20 @@ namespace mat {
 			/* operators */
 			friend std::ostream &operator<<(std::ostream &out, const BaseMat &m);
 			friend BaseMat operator*(BaseMat m, const float other);
-			friend BaseMat operator*(BaseMat m, const BaseMat other);
+			friend BaseMat operator*(const BaseMat &m, const BaseMat &other);
 			friend BaseMat operator+(BaseMat m, const float other);
-			friend BaseMat operator+(BaseMat m, const BaseMat other);
+			friend BaseMat operator+(BaseMat m, const BaseMat &other);
 			friend BaseMat operator-(BaseMat m, const float other);
-			friend BaseMat operator-(BaseMat m, const BaseMat other);
-			friend bool operator==(BaseMat m, const BaseMat other);
+			friend BaseMat operator-(BaseMat m, const BaseMat &other);
+			friend bool operator==(const BaseMat &m, const BaseMat &other);
 			BaseMat &operator=(const BaseMat &other);
+			BaseMat &operator=(BaseMat &&other);
+			BaseMat &operator*=(const float other);
+			BaseMat &operator*=(const BaseMat &other);
+			BaseMat &operator+=(const float other);
+			BaseMat &operator+=(const BaseMat &other);
+			BaseMat &operator-=(const float other);
+			BaseMat &operator-=(const BaseMat &other);
 			explicit operator std::vector<float>() const { return *_data; };
 			explicit operator float*() const { return static_cast<float*>(&(*_data)[0]); };
 
@@ -75,6 +83,8 @@ namespace mat {
 			Vec(int size);
 			Vec(BaseMat mat);
 			Vec(int size, std::vector<float> data);
+			Vec(const Vec &v);
+			Vec(Vec &&v);
 			~Vec();
 
 			int getSize() const;
@@ -82,7 +92,12 @@ namespace mat {
 			float &get(int x);
 			const float &operator[](const int idx) const;
 			float &operator[](const int idx);
-			Vec &operator=(const Vec &other);
+			Vec &operator=(const Vec &other);  // no move assignment: xyzw must stay bound to our data
+			Vec &operator*=(const float other);
+			Vec &operator+=(const float other);
+			Vec &operator+=(const BaseMat &other);
+			Vec &operator-=(const float other);
+			Vec &operator-=(const BaseMat &other);
 			float dot(const Vec &v) const;
 			Vec normalize() const;
 
@@ -97,86 +112,34 @@ namespace mat {
 			float &g;
 			float &b;
 
-			friend Vec operator*(const Vec &v, const float other);
-			friend Vec operator+(const Vec &m, const float other);
-			friend Vec operator+(const Vec &m, const BaseMat other);
-			friend Vec operator-(const Vec &m, const float other);
-			friend Vec operator-(const Vec &m, const BaseMat other);
+			friend Vec operator*(Vec v, const float other);
+			friend Vec operator+(Vec v, const float other);
+			friend Vec operator+(Vec v, const BaseMat &other);
+			friend Vec operator-(Vec v, const float other);
+			friend Vec operator-(Vec v, const BaseMat &other);
 		protected:
 		private:
 	};
-	class Vec2 : public Vec {
-		public:
-			Vec2();  // 0 0
-			Vec2(const Vec2 &vec);
-			Vec2(const BaseMat &mat);
-			Vec2(std::vector<float> data);
-			Vec2(float _x, float _y);
-			~Vec2();
-
-			friend Vec2 operator*(const Vec2 &v, const float other);
-			friend Vec2 operator+(const Vec2 &m, const float other);
-			friend Vec2 operator+(const Vec2 &m, const BaseMat other);
-			friend Vec2 operator-(const Vec2 &m, const float other);
-			friend Vec2 operator-(const Vec2 &m, const BaseMat other);
-		protected:
-		private:
-	};
-	class Vec3 : public Vec {
-		public:
-			Vec3();  // 0 0 0
-			Vec3(const Vec3 &vec);
-			Vec3(const Vec4 &vec4);
-			Vec3(const BaseMat &mat);
-			Vec3(std::vector<float> data);
-			Vec3(float _x, float _y, float _z);
-			~Vec3();
-
-			Vec3 cross(const Vec3 &v) const;
-			float dot(const Vec3 &v) const;
-
-			friend Vec3 operator*(const Vec3 &v, const float other);
-			friend Vec3 operator+(const Vec3 &m, const float other);
-			friend Vec3 operator+(const Vec3 &m, const BaseMat other);
-			friend Vec3 operator-(const Vec3 &m, const float other);
-			friend Vec3 operator-(const Vec3 &m, const BaseMat other);
-		protected:
-		private:
-	};
-	class Vec4 : public Vec {
-		public:
-			Vec4();  // 0 0 0 1
-			Vec4(const Vec4 &vec);
-			Vec4(const Vec3 &vec3);
-			Vec4(const BaseMat &mat);
-			Vec4(std::vector<float> data);
-			Vec4(float _x, float _y, float _z, float _w=1);
-			~Vec4();
-
-			friend Vec4 operator*(const Vec4 &v, const float other);
-			friend Vec4 operator+(const Vec4 &m, const float other);
-			friend Vec4 operator+(const Vec4 &m, const BaseMat other);
-			friend Vec4 operator-(const Vec4 &m, const float other);
-			friend Vec4 operator-(const Vec4 &m, const BaseMat other);
-		protected:
-		private:
-	};
-
 	class SquareMat : public BaseMat {
 		public:
 			SquareMat(int size, bool identity=true);
 			SquareMat(BaseMat mat);
 			SquareMat(int size, std::vector<float> data);
+			SquareMat(const SquareMat &m) = default;
+			SquareMat(SquareMat &&m) = default;
 			~SquareMat();
 
+			SquareMat &operator=(const SquareMat &other) = default;
+			SquareMat &operator=(SquareMat &&other) = default;
+
 			int getSize() const;
 
 			friend SquareMat operator*(SquareMat m, const float other);
-			friend SquareMat operator*(SquareMat m, const BaseMat other);
+			friend SquareMat operator*(const SquareMat &m, const BaseMat &other);  // new matrix: m is not copied
 			friend SquareMat operator+(SquareMat m, const float other);
-			friend SquareMat operator+(SquareMat m, const BaseMat other);
+			friend SquareMat operator+(SquareMat m, const BaseMat &other);
 			friend SquareMat operator-(SquareMat m, const float other);
-			friend SquareMat operator-(SquareMat m, const BaseMat other);
+			friend SquareMat operator-(SquareMat m, const BaseMat &other);
 		protected:
 		private:
 	};
@@ -185,14 +148,19 @@ namespace mat {
 			Mat2(bool identity=true);
 			Mat2(SquareMat mat);
 			Mat2(std::vector<float> data);
+			Mat2(const Mat2 &m) = default;
+			Mat2(Mat2 &&m) = default;
 			~Mat2();
 
+			Mat2 &operator=(const Mat2 &other) = default;
+			Mat2 &operator=(Mat2 &&other) = default;
+
 			friend Mat2 operator*(Mat2 m, const float other);
-			friend Mat2 operator*(Mat2 m, const BaseMat other);
+			friend Mat2 operator*(const Mat2 &m, const BaseMat &other);  // new matrix: m is not copied
 			friend Mat2 operator+(Mat2 m, const float other);
-			friend Mat2 operator+(Mat2 m, const BaseMat other);
+			friend Mat2 operator+(Mat2 m, const BaseMat &other);
 			friend Mat2 operator-(Mat2 m, const float other);
-			friend Mat2 operator-(Mat2 m, const BaseMat other);
+			friend Mat2 operator-(Mat2 m, const BaseMat &other);
 		protected:
 		private:
 	};
@@ -201,46 +169,230 @@ namespace mat {
 			Mat3(bool identity=true);
 			Mat3(SquareMat mat);
 			Mat3(std::vector<float> data);
+			Mat3(const Mat3 &m) = default;
+			Mat3(Mat3 &&m) = default;
 			~Mat3();
 
+			Mat3 &operator=(const Mat3 &other) = default;
+			Mat3 &operator=(Mat3 &&other) = default;
+
 			friend Mat3 operator*(Mat3 m, const float other);
-			friend Mat3 operator*(Mat3 m, const BaseMat other);
+			friend Mat3 operator*(const Mat3 &m, const BaseMat &other);  // new matrix: m is not copied
 			friend Mat3 operator+(Mat3 m, const float other);
-			friend Mat3 operator+(Mat3 m, const BaseMat other);
+			friend Mat3 operator+(Mat3 m, const BaseMat &other);
 			friend Mat3 operator-(Mat3 m, const float other);
-			friend Mat3 operator-(Mat3 m, const BaseMat other);
+			friend Mat3 operator-(Mat3 m, const BaseMat &other);
 		protected:
 		private:
 	};
-	class Mat4 : public SquareMat {
+	/*
+	fixed size vectors and matrix
+	the data are stored inline (no heap allocation) so they can be copied like a float[N]
+	*/
+	class Vec2 {
+		public:
+			Vec2();  // 0 0
+			Vec2(const BaseMat &mat);
+			Vec2(std::vector<float> data);
+			Vec2(float _x, float _y);
+
+			int getSize() const { return 2; }
+			const float &get(int idx) const { return data[idx]; }
+			float &get(int idx) { return data[idx]; }
+			const float *getData() const { return data; }
+			float *getData() { return data; }
+			const float &operator[](const int idx) const { return data[idx]; }
+			float &operator[](const int idx) { return data[idx]; }
+			float dot(const Vec2 &v) const;
+			Vec2 normalize() const;
+
+			explicit operator BaseMat() const;
+			explicit operator std::vector<float>() const { return std::vector<float>(data, data + 2); }
+			explicit operator float*() const { return const_cast<float*>(data); }
+
+			Vec2 &operator*=(const float other) { x *= other; y *= other; return *this; }
+			Vec2 &operator+=(const float other) { x += other; y += other; return *this; }
+			Vec2 &operator+=(const Vec2 &other) { x += other.x; y += other.y; return *this; }
+			Vec2 &operator-=(const float other) { x -= other; y -= other; return *this; }
+			Vec2 &operator-=(const Vec2 &other) { x -= other.x; y -= other.y; return *this; }
+
+			friend std::ostream &operator<<(std::ostream &out, const Vec2 &v);
+			friend Vec2 operator*(const Vec2 &v, const float other) { return Vec2(v.x * other, v.y * other); }
+			friend Vec2 operator+(const Vec2 &v, const float other) { return Vec2(v.x + other, v.y + other); }
+			friend Vec2 operator+(const Vec2 &v, const Vec2 &other) { return Vec2(v.x + other.x, v.y + other.y); }
+			friend Vec2 operator-(const Vec2 &v, const float other) { return Vec2(v.x - other, v.y - other); }
+			friend Vec2 operator-(const Vec2 &v, const Vec2 &other) { return Vec2(v.x - other.x, v.y - other.y); }
+			friend bool operator==(const Vec2 &v, const Vec2 &other) { return v.x == other.x && v.y == other.y; }
+
+			union {
+				float data[2];
+				struct { float x, y; };
+				struct { float r, g; };
+			};
+	};
+	class Vec3 {
+		public:
+			Vec3();  // 0 0 0
+			Vec3(const Vec4 &vec4);
+			Vec3(const BaseMat &mat);
+			Vec3(std::vector<float> data);
+			Vec3(float _x, float _y, float _z);
+
+			int getSize() const { return 3; }
+			const float &get(int idx) const { return data[idx]; }
+			float &get(int idx) { return data[idx]; }
+			const float *getData() const { return data; }
+			float *getData() { return data; }
+			const float &operator[](const int idx) const { return data[idx]; }
+			float &operator[](const int idx) { return data[idx]; }
+			Vec3 cross(const Vec3 &v) const;
+			float dot(const Vec3 &v) const { return x * v.x + y * v.y + z * v.z; }
+			Vec3 normalize() const;
+
+			explicit operator BaseMat() const;
+			explicit operator std::vector<float>() const { return std::vector<float>(data, data + 3); }
+			explicit operator float*() const { return const_cast<float*>(data); }
+
+			Vec3 &operator*=(const float other) { x *= other; y *= other; z *= other; return *this; }
+			Vec3 &operator+=(const float other) { x += other; y += other; z += other; return *this; }
+			Vec3 &operator+=(const Vec3 &other) { x += other.x; y += other.y; z += other.z; return *this; }
+			Vec3 &operator-=(const float other) { x -= other; y -= other; z -= other; return *this; }
+			Vec3 &operator-=(const Vec3 &other) { x -= other.x; y -= other.y; z -= other.z; return *this; }
+
+			friend std::ostream &operator<<(std::ostream &out, const Vec3 &v);
+			friend Vec3 operator*(const Vec3 &v, const float other) {
+				return Vec3(v.x * other, v.y * other, v.z * other); }
+			friend Vec3 operator+(const Vec3 &v, const float other) {
+				return Vec3(v.x + other, v.y + other, v.z + other); }
+			friend Vec3 operator+(const Vec3 &v, const Vec3 &other) {
+				return Vec3(v.x + other.x, v.y + other.y, v.z + other.z); }
+			friend Vec3 operator-(const Vec3 &v, const float other) {
+				return Vec3(v.x - other, v.y - other, v.z - other); }
+			friend Vec3 operator-(const Vec3 &v, const Vec3 &other) {
+				return Vec3(v.x - other.x, v.y - other.y, v.z - other.z); }
+			friend bool operator==(const Vec3 &v, const Vec3 &other) {
+				return v.x == other.x && v.y == other.y && v.z == other.z; }
+
+			union {
+				float data[3];
+				struct { float x, y, z; };
+				struct { float r, g, b; };
+			};
+	};
+	class Vec4 {
+		public:
+			Vec4();  // 0 0 0 1
+			Vec4(const Vec3 &vec3);
+			Vec4(const BaseMat &mat);
+			Vec4(std::vector<float> data);
+			Vec4(float _x, float _y, float _z, float _w=1);
+
+			int getSize() const { return 4; }
+			const float &get(int idx) const { return data[idx]; }
+			float &get(int idx) { return data[idx]; }
+			const float *getData() const { return data; }
+			float *getData() { return data; }
+			const float &operator[](const int idx) const { return data[idx]; }
+			float &operator[](const int idx) { return data[idx]; }
+			float dot(const Vec4 &v) const { return x * v.x + y * v.y + z * v.z + w * v.w; }
+			Vec4 normalize() const;
+
+			explicit operator BaseMat() const;
+			explicit operator std::vector<float>() const { return std::vector<float>(data, data + 4); }
+			explicit operator float*() const { return const_cast<float*>(data); }
+
+			Vec4 &operator*=(const float other) { x *= other; y *= other; z *= other; w *= other; return *this; }
+			Vec4 &operator+=(const float other) { x += other; y += other; z += other; w += other; return *this; }
+			Vec4 &operator+=(const Vec4 &other) { x += other.x; y += other.y; z += other.z; w += other.w; return *this; }
+			Vec4 &operator-=(const float other) { x -= other; y -= other; z -= other; w -= other; return *this; }
+			Vec4 &operator-=(const Vec4 &other) { x -= other.x; y -= other.y; z -= other.z; w -= other.w; return *this; }
+
+			friend std::ostream &operator<<(std::ostream &out, const Vec4 &v);
+			friend Vec4 operator*(const Vec4 &v, const float other) {
+				return Vec4(v.x * other, v.y * other, v.z * other, v.w * other); }
+			friend Vec4 operator+(const Vec4 &v, const float other) {
+				return Vec4(v.x + other, v.y + other, v.z + other, v.w + other); }
+			friend Vec4 operator+(const Vec4 &v, const Vec4 &other) {
+				return Vec4(v.x + other.x, v.y + other.y, v.z + other.z, v.w + other.w); }
+			friend Vec4 operator-(const Vec4 &v, const float other) {
+				return Vec4(v.x - other, v.y - other, v.z - other, v.w - other); }
+			friend Vec4 operator-(const Vec4 &v, const Vec4 &other) {
+				return Vec4(v.x - other.x, v.y - other.y, v.z - other.z, v.w - other.w); }
+			friend bool operator==(const Vec4 &v, const Vec4 &other) {
+				return v.x == other.x && v.y == other.y && v.z == other.z && v.w == other.w; }
+
+			union {
+				float data[4];
+				struct { float x, y, z, w; };
+				struct { float r, g, b, a; };
+			};
+	};
+
+	class Mat4 {
 		public:
 			Mat4(bool identity=true);
-			Mat4(SquareMat mat);
+			Mat4(const BaseMat &mat);
 			Mat4(std::vector<float> data);
-			~Mat4();
 
-			Mat4 scale(Vec3 val);  // scale martix
-			Mat4 scale(float val);  // scale martix
-			Mat4 scale(float valX, float valY, float valZ);  // scale martix
+			int getLns() const { return 4; }
+			int getCols() const { return 4; }
+			int getSize() const { return 4; }
+			const float *getData() const { return _data; }
+			float *getData() { return _data; }
+			float &get(int ln, int col) { return _data[ln * 4 + col]; }
+			const float &get(int ln, int col) const { return _data[ln * 4 + col]; }
 
-			Mat4 translate(Vec3 val);  // translate martix
-			Mat4 translate(float valX, float valY, float valZ);  // translate martix
+			Mat4 scale(Vec3 val) const;  // scale martix
+			Mat4 scale(float val) const;  // scale martix
+			Mat4 scale(float valX, float valY, float valZ) const;  // scale martix
 
-			Mat4 rotateRad(float radians, Vec3 axis);  // rotate around axis
-			Mat4 rotateRad(float radians, float axX, float axY, float axZ);  // rotate around axis
-			Mat4 rotateDeg(float degrees, Vec3 axis);  // rotate around axis
-			Mat4 rotateDeg(float degrees, float axX, float axY, float axZ);  // rotate around axis
+			Mat4 translate(Vec3 val) const;  // translate martix
+			Mat4 translate(float valX, float valY, float valZ) const;  // translate martix
 
-			Mat4 lookAt(const Vec3 &src, const Vec3 &dst);  // look at a position
-			Mat4 perspective(float fov_y, float aspect, float z_near, float z_far);
+			Mat4 rotateRad(float radians, Vec3 axis) const;  // rotate around axis
+			Mat4 rotateRad(float radians, float axX, float axY, float axZ) const;  // rotate around axis
+			Mat4 rotateDeg(float degrees, Vec3 axis) const;  // rotate around axis
+			Mat4 rotateDeg(float degrees, float axX, float axY, float axZ) const;  // rotate around axis
+
+			Mat4 lookAt(const Vec3 &src, const Vec3 &dst) const;  // look at a position
+			Mat4 perspective(float fov_y, float aspect, float z_near, float z_far) const;
+
+			Mat4 transpose() const;
+			Mat4 inverse() const;  // throw std::invalid_argument if the matrix is not invertible
+			Mat4 affineInverse() const;  // faster inverse, only for a matrix with 0 0 0 1 as last line
+
+			/* operators */
+			friend std::ostream &operator<<(std::ostream &out, const Mat4 &m);
+			friend Mat4 operator*(const Mat4 &m, const float other);
+			friend Mat4 operator*(const Mat4 &m, const Mat4 &other);
+			friend Vec4 operator*(const Mat4 &m, const Vec4 &other);
+			friend Mat4 operator+(const Mat4 &m, const float other);
+			friend Mat4 operator+(const Mat4 &m, const Mat4 &other);
+			friend Mat4 operator-(const Mat4 &m, const float other);
+			friend Mat4 operator-(const Mat4 &m, const Mat4 &other);
+			friend bool operator==(const Mat4 &m, const Mat4 &other);
+			Mat4 &operator*=(const float other);
+			Mat4 &operator*=(const Mat4 &other);  // this = this * other
+			Mat4 &operator+=(const float other);
+			Mat4 &operator+=(const Mat4 &other);
+			Mat4 &operator-=(const float other);
+			Mat4 &operator-=(const Mat4 &other);
+			explicit operator BaseMat() const;
+			explicit operator std::vector<float>() const { return std::vector<float>(_data, _data + 16); }
+			explicit operator float*() const { return const_cast<float*>(_data); }
+
+			// operator [][] -> return a pointer on the line
+			float *operator[](int line) { return _data + line * 4; }
+			const float *operator[](int line) const { return _data + line * 4; }
 
-			friend Mat4 operator*(Mat4 m, const float other);
-			friend Mat4 operator*(Mat4 m, const BaseMat other);
-			friend Mat4 operator+(Mat4 m, const float other);
-			friend Mat4 operator+(Mat4 m, const BaseMat other);
-			friend Mat4 operator-(Mat4 m, const float other);
-			friend Mat4 operator-(Mat4 m, const BaseMat other);
 		protected:
+			/*
+			for the Matrix:
+			| 1 2 |
+			| 3 4 |
+			float data[] = {1, 2, 3, 4};
+			*/
+			alignas(16) float _data[16];
 		private:
 	};
 
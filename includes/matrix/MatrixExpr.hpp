@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstring>
+#include "Matrix.hpp"
+#include "Affine.hpp"
+#include "MatrixSimd.hpp"
+
+namespace mat {
+	/*
+	opt-in lazy evaluation of Mat4 / Affine product chains
+		Mat4 res = expr::lazy(a) * b * c;  // same result as a * b * c
+		(expr::lazy(a) * b * c).evalTo(dst);  // written directly in dst
+	the result is computed line by line: (a * b * c)[i] = (a[i] * b) * c
+	so there is no intermediate matrix, only a float[4] on the stack
+	the operands are kept by pointer: evaluate the expression before they are destroyed
+	*/
+	namespace expr {
+		/*
+		every node of an expression has:
+			isAffine                -> true if the last line is always 0 0 0 1
+			line(ln, out)           -> out = line ln of the expression
+			mulLine(v, out)         -> out = v * expression (v is a line vector)
+			mulVec(v, out)          -> out = expression * v
+		*/
+		template<class E>
+		class Expr {
+			public:
+				const E &self() const { return static_cast<const E&>(*this); }
+
+				// dst must not be one of the operands (except the first one)
+				void evalTo(Mat4 &dst) const {
+					for (int ln=0; ln < 4; ln++) {
+						self().line(ln, dst.getData() + ln * 4);
+					}
+				}
+				void evalTo(Affine &dst) const {
+					static_assert(E::isAffine, "the expression is not an affine transformation");
+					for (int ln=0; ln < 3; ln++) {
+						self().line(ln, dst.getData() + ln * 4);
+					}
+				}
+
+				operator Mat4() const { Mat4 res(false); evalTo(res); return res; }
+				operator Affine() const { Affine res; evalTo(res); return res; }
+		};
+
+		class Mat4Ref : public Expr<Mat4Ref> {
+			public:
+				static const bool isAffine = false;
+				explicit Mat4Ref(const Mat4 &m) : _m(m.getData()) {}
+
+				void line(int ln, float *out) const { memcpy(out, _m + ln * 4, 4 * sizeof(float)); }
+				void mulLine(const float *v, float *out) const { simd::mulRow(v, _m, out); }
+				void mulVec(const float *v, float *out) const { simd::mulVec(_m, v, out); }
+			private:
+				const float *_m;
+		};
+
+		class AffineRef : public Expr<AffineRef> {
+			public:
+				static const bool isAffine = true;
+				explicit AffineRef(const Affine &m) : _m(m.getData()) {}
+
+				void line(int ln, float *out) const {
+					if (ln < 3) {
+						memcpy(out, _m + ln * 4, 4 * sizeof(float));
+					}
+					else {
+						out[0] = 0;
+						out[1] = 0;
+						out[2] = 0;
+						out[3] = 1;
+					}
+				}
+				void mulLine(const float *v, float *out) const { simd::mulRowAffine(v, _m, out); }
+				void mulVec(const float *v, float *out) const {
+					float res[3];
+					for (int ln=0; ln < 3; ln++) {
+						res[ln] = _m[ln * 4] * v[0] + _m[ln * 4 + 1] * v[1] + _m[ln * 4 + 2] * v[2] + _m[ln * 4 + 3] * v[3];
+					}
+					out[3] = v[3];
+					memcpy(out, res, sizeof(res));
+				}
+			private:
+				const float *_m;
+		};
+
+		template<class L, class R>
+		class Product : public Expr<Product<L, R> > {
+			public:
+				static const bool isAffine = L::isAffine && R::isAffine;
+				Product(const L &l, const R &r) : _l(l), _r(r) {}
+
+				void line(int ln, float *out) const {
+					alignas(16) float tmp[4];
+					_l.line(ln, tmp);
+					_r.mulLine(tmp, out);
+				}
+				void mulLine(const float *v, float *out) const {
+					alignas(16) float tmp[4];
+					_l.mulLine(v, tmp);
+					_r.mulLine(tmp, out);
+				}
+				void mulVec(const float *v, float *out) const {
+					alignas(16) float tmp[4];
+					_r.mulVec(v, tmp);
+					_l.mulVec(tmp, out);
+				}
+			private:
+				// the nodes are only pointers on the operands: copy them
+				L _l;
+				R _r;
+		};
+
+		inline Mat4Ref lazy(const Mat4 &m) { return Mat4Ref(m); }
+		inline AffineRef lazy(const Affine &m) { return AffineRef(m); }
+
+		/* operators */
+		template<class L, class R>
+		Product<L, R> operator*(const Expr<L> &l, const Expr<R> &r) { return Product<L, R>(l.self(), r.self()); }
+		template<class L>
+		Product<L, Mat4Ref> operator*(const Expr<L> &l, const Mat4 &r) { return Product<L, Mat4Ref>(l.self(), Mat4Ref(r)); }
+		template<class L>
+		Product<L, AffineRef> operator*(const Expr<L> &l, const Affine &r) {
+			return Product<L, AffineRef>(l.self(), AffineRef(r)); }
+		template<class R>
+		Product<Mat4Ref, R> operator*(const Mat4 &l, const Expr<R> &r) { return Product<Mat4Ref, R>(Mat4Ref(l), r.self()); }
+		template<class R>
+		Product<AffineRef, R> operator*(const Affine &l, const Expr<R> &r) {
+			return Product<AffineRef, R>(AffineRef(l), r.self()); }
+		template<class E>
+		Vec4 operator*(const Expr<E> &e, const Vec4 &v) {
+			Vec4 res;
+			e.self().mulVec(v.getData(), res.getData());
+			return res;
+		}
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+/*
+kernels used by mat::Mat4 (row major float[16] and float[4] vectors)
+the instruction set is chosen at compile time:
+	MAT_SIMD_AVX  -> compiled with -mavx (or -march=native on an avx cpu)
+	MAT_SIMD_SSE  -> default on x86_64
+	MAT_SIMD_NONE -> other cpu or forced with -D MAT_SIMD=0
+the output can be one of the inputs
+the scalar kernels are always compiled so the simd ones can be checked against them
+*/
+#define MAT_SIMD_NONE	0
+#define MAT_SIMD_SSE	1
+#define MAT_SIMD_AVX	2
+
+#ifndef MAT_SIMD
+	#if defined(__AVX__)
+		#define MAT_SIMD MAT_SIMD_AVX
+	#elif defined(__SSE2__) || defined(_M_X64)
+		#define MAT_SIMD MAT_SIMD_SSE
+	#else
+		#define MAT_SIMD MAT_SIMD_NONE
+	#endif
+#endif
+
+namespace mat {
+	namespace simd {
+		const char *name();  // name of the instruction set used ("avx", "sse" or "scalar")
+
+		void mul(const float *a, const float *b, float *out);  // out = a * b
+		void mulVec(const float *m, const float *v, float *out);  // out = m * v
+		void transpose(const float *m, float *out);
+		bool inverse(const float *m, float *out);  // return false if m is not invertible
+		bool affineInverse(const float *m, float *out);  // m last line must be 0 0 0 1
+		void mulAffine(const float *a, const float *b, float *out);  // 3x4 matrix (implicit 0 0 0 1 last line)
+		void mulRow(const float *v, const float *m, float *out);  // out = v * m (v is a line vector)
+		void mulRowAffine(const float *v, const float *a, float *out);  // out = v * a (a is 3x4)
+
+		/* reference implementation (no simd) */
+		void mulScalar(const float *a, const float *b, float *out);
+		void mulVecScalar(const float *m, const float *v, float *out);
+		void transposeScalar(const float *m, float *out);
+		bool inverseScalar(const float *m, float *out);
+		bool affineInverseScalar(const float *m, float *out);
+		void mulAffineScalar(const float *a, const float *b, float *out);
+		void mulRowScalar(const float *v, const float *m, float *out);
+		void mulRowAffineScalar(const float *v, const float *a, float *out);
+	}
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <iostream>
+#include "Matrix.hpp"
+
+namespace mat {
+	/*
+	fixed size matrix, the size is checked at compile time
+		constexpr Matrix<2, 3> m(1, 2, 3,
+		                         4, 5, 6);
+		constexpr Matrix<3, 2> t = m.transpose();
+		constexpr Matrix<2, 2> p = m * t;  // m * m -> compile error "wrong matrix size"
+	all the operations are constexpr (c++14) and the loops have constant bounds
+	so they are fully unrolled by the compiler
+	the data are stored line by line like the other matrix
+	*/
+	template<int R, int C, typename T = float>
+	class Matrix {
+		static_assert(R > 0 && C > 0, "wrong matrix size");
+		public:
+			constexpr Matrix() : _data{} {}  // zero matrix
+			// one value for each element (line by line)
+			template<typename... Args>
+			constexpr Matrix(T first, Args... values) : _data{first, static_cast<T>(values)...} {
+				static_assert(sizeof...(Args) + 1 == R * C, "wrong matrix size");
+			}
+
+			static constexpr Matrix identity() {
+				static_assert(R == C, "identity of a non square matrix");
+				Matrix res;
+				for (int i=0; i < R; i++) {
+					res._data[i * C + i] = 1;
+				}
+				return res;
+			}
+
+			constexpr int getLns() const { return R; }
+			constexpr int getCols() const { return C; }
+			constexpr int getSize() const { return R * C; }
+			constexpr const T *getData() const { return _data; }
+			constexpr T *getData() { return _data; }
+			constexpr T &get(int ln, int col) { return _data[ln * C + col]; }
+			constexpr const T &get(int ln, int col) const { return _data[ln * C + col]; }
+
+			constexpr Matrix<C, R, T> transpose() const {
+				Matrix<C, R, T> res;
+				for (int ln=0; ln < R; ln++) {
+					for (int col=0; col < C; col++) {
+						res.get(col, ln) = get(ln, col);
+					}
+				}
+				return res;
+			}
+
+			/* operators */
+			template<int R2, int C2>
+			constexpr Matrix<R, C2, T> operator*(const Matrix<R2, C2, T> &other) const {
+				static_assert(C == R2, "wrong matrix size");
+				Matrix<R, C2, T> res;
+				for (int ln=0; ln < R; ln++) {
+					for (int col=0; col < C2; col++) {
+						T r = 0;
+						for (int i=0; i < C; i++) {
+							r += get(ln, i) * other.get(i, col);
+						}
+						res.get(ln, col) = r;
+					}
+				}
+				return res;
+			}
+			constexpr Matrix operator*(const T other) const {
+				Matrix res = *this;
+				for (int i=0; i < R * C; i++) {
+					res._data[i] *= other;
+				}
+				return res;
+			}
+			constexpr Matrix operator+(const Matrix &other) const {
+				Matrix res = *this;
+				for (int i=0; i < R * C; i++) {
+					res._data[i] += other._data[i];
+				}
+				return res;
+			}
+			constexpr Matrix operator-(const Matrix &other) const {
+				Matrix res = *this;
+				for (int i=0; i < R * C; i++) {
+					res._data[i] -= other._data[i];
+				}
+				return res;
+			}
+			constexpr bool operator==(const Matrix &other) const {
+				for (int i=0; i < R * C; i++) {
+					if (_data[i] != other._data[i])
+						return false;
+				}
+				return true;
+			}
+			constexpr bool operator!=(const Matrix &other) const { return !(*this == other); }
+
+			// conversion to the runtime matrix (with the simd operations)
+			explicit operator Mat4() const {
+				static_assert(R == 4 && C == 4, "wrong matrix size");
+				Mat4 res(false);
+				for (int i=0; i < 16; i++) {
+					res.getData()[i] = static_cast<float>(_data[i]);
+				}
+				return res;
+			}
+			explicit operator BaseMat() const {
+				std::vector<float> data(_data, _data + R * C);
+				return BaseMat(R, C, data);
+			}
+
+			// operator [][] -> return a pointer on the line
+			constexpr T *operator[](int line) { return _data + line * C; }
+			constexpr const T *operator[](int line) const { return _data + line * C; }
+
+		protected:
+			T _data[R * C];
+		private:
+	};
+
+	template<int R, int C, typename T>
+	std::ostream &operator<<(std::ostream &out, const Matrix<R, C, T> &m) { return out << BaseMat(m); }
+}
@@ -5,8 +5,9 @@
 namespace mat {
 	class Quaternion {
 		public:
-			Quaternion();
+			Quaternion();  // identity (no rotation)
 			Quaternion(float degrees, const Vec3 &v);
+			Quaternion(float w_, float x, float y, float z);
 
 			const Quaternion inverted() const;
 			const Quaternion operator*(const Quaternion &other) const;  // multiplication btw 2 rotations
@@ -14,10 +15,11 @@ namespace mat {
 			const Vec4 operator*(const Vec4 &other) const;  // apply rotation to the vector
 			const Quaternion operator^(float t) const;
 			const Quaternion slerp(const Quaternion &to, float step) const;  // get a point btw this and to (with t btw 0 & 1)
+			const Quaternion nlerp(const Quaternion &to, float step) const;  // faster than slerp, but not a constant speed
 			const Quaternion normalize() const;
 
 			void toAxisAngle(float &flAngle, Vec3 &vecAxis) const;  // get axis and angle from quaterion
-			Mat4 toMatrix() const;
+			Mat4 toMatrix() const;  // rotation matrix (the quaternion doesn't need to be normalized)
 
 			/* operators */
 			friend std::ostream &operator<<(std::ostream &out, const Quaternion &q);
@@ -28,6 +30,25 @@ namespace mat {
 		private:
 	};
 	const Quaternion slerp(const Quaternion &from, const Quaternion &to, float step);
+	const Quaternion nlerp(const Quaternion &from, const Quaternion &to, float step);
+
+	/*
+	array of quaternions stored in SoA form: the quaternion i is (w[i], x[i], y[i], z[i])
+	used to process a lot of rotations at once with simd
+	the output can be one of the inputs
+	*/
+	struct QuaternionSoA {
+		float *x;
+		float *y;
+		float *z;
+		float *w;
+	};
+	void normalizeBatch(const QuaternionSoA &q, const QuaternionSoA &out, int count);
+	void mulBatch(const QuaternionSoA &a, const QuaternionSoA &b, const QuaternionSoA &out, int count);  // a * b
+	void nlerpBatch(const QuaternionSoA &from, const QuaternionSoA &to, const float *steps, \
+		const QuaternionSoA &out, int count);
+	void slerpBatch(const QuaternionSoA &from, const QuaternionSoA &to, const float *steps, \
+		const QuaternionSoA &out, int count);
 }
 
 /*
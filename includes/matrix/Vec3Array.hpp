@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Matrix.hpp"
+#include "Affine.hpp"
+
+namespace mat {
+	/*
+	array of Vec3 stored in SoA form: the vector i is (getX()[i], getY()[i], getZ()[i])
+	the 3 spans are in the same allocation and aligned on 32 bytes (one avx register)
+	used to process a lot of points at once with simd
+	*/
+	class Vec3Array {
+		public:
+			Vec3Array();
+			explicit Vec3Array(int size);  // init with 0 0 0
+			Vec3Array(const Vec3Array &other);
+			Vec3Array(Vec3Array &&other);
+			~Vec3Array();
+
+			int getSize() const { return _size; }
+			void resize(int size);  // keep the current values, the new ones are 0 0 0
+			// copy from an array of structures (ex: aiVector3D *) -> stride is the number of float between 2 vectors
+			void load(const float *data, int count, int stride=3);
+
+			const float *getX() const { return _data; }
+			float *getX() { return _data; }
+			const float *getY() const { return _data + _capacity; }
+			float *getY() { return _data + _capacity; }
+			const float *getZ() const { return _data + 2 * _capacity; }
+			float *getZ() { return _data + 2 * _capacity; }
+			Vec3 get(int idx) const { return Vec3(getX()[idx], getY()[idx], getZ()[idx]); }
+			void set(int idx, const Vec3 &v);
+
+			Vec3Array &operator=(const Vec3Array &other);
+			Vec3Array &operator=(Vec3Array &&other);
+
+		protected:
+			int _size;
+			int _capacity;  // size of each span (multiple of 8)
+			float *_data;  // x[_capacity] y[_capacity] z[_capacity]
+		private:
+	};
+
+	/*
+	batch operations (out is resized to the input size, it can be one of the inputs)
+	transformPoints  -> out[i] = m * (in[i], 1) (the last line of m is ignored)
+	transformNormals -> out[i] = m * (in[i], 0) (m should be the inverse transpose if the scale is not uniform)
+	*/
+	void transformPoints(const Mat4 &m, const Vec3Array &in, Vec3Array &out);
+	void transformPoints(const Affine &m, const Vec3Array &in, Vec3Array &out);
+	void transformNormals(const Mat4 &m, const Vec3Array &in, Vec3Array &out);
+	void transformNormals(const Affine &m, const Vec3Array &in, Vec3Array &out);
+	void bounds(const Vec3Array &in, Vec3 &min, Vec3 &max);  // axis aligned bounding box
+	void dot(const Vec3Array &a, const Vec3Array &b, float *out);  // out must have a.getSize() elements
+	void cross(const Vec3Array &a, const Vec3Array &b, Vec3Array &out);
+
+	/*
+	linear interpolation of float arrays (any alignment, out can be a or b)
+	out[i] = a[i] + (b[i] - a[i]) * step (or steps[i])
+	*/
+	void lerpBatch(const float *a, const float *b, float step, float *out, int count);
+	void lerpBatch(const float *a, const float *b, const float *steps, float *out, int count);
+}
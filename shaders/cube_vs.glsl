@@ -15,13 +15,13 @@ uniform mat4	model;
 uniform mat4	view;
 uniform mat4	projection;
 uniform mat4	modelScale;
-uniform mat4	bones[MAX_BONES];
+uniform mat3x4	bones[MAX_BONES];  // affine bones transform, used as: vec4 * bones[i]
 uniform vec3	bonesPos[MAX_BONES];
 uniform int		boneID;
 uniform float	cubeSize;
 
 void main() {
-    mat4 boneTransform = modelScale * bones[boneID];
+    mat4 boneTransform = modelScale * mat4(transpose(bones[boneID]));
 
 	vec4 cPos = boneTransform * vec4(bonesPos[boneID], 1.0);
 
@@ -23,7 +23,7 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 uniform mat4 modelScale;
-uniform mat4 bones[MAX_BONES];
+uniform mat3x4 bones[MAX_BONES];  // affine bones transform, used as: vec4 * bones[i]
 
 struct DirLight {
 	vec3		direction;
@@ -37,16 +37,16 @@ uniform vec3 viewPos;
 uniform DirLight dirLight;
 
 void main() {
-	mat4 boneTransform = mat4(0.0);
+	mat3x4 boneTransform = mat3x4(0.0);
 	for (int i=0; i < NUM_BONES_PER_VERTEX; i++) {
 		boneTransform += bones[bonesID[i]] * bonesWeight[i];
 	}
 	if (!isAnimated)
-		boneTransform = mat4(1.0);
+		boneTransform = mat3x4(1.0);
 
-	vec4 pos = boneTransform * vec4(aPos, 1.0);
+	vec4 pos = vec4(vec4(aPos, 1.0) * boneTransform, 1.0);
 
-	vec4 boneNormal = boneTransform * vec4(aNormal, 0);
+	vec3 boneNormal = vec4(aNormal, 0.0) * boneTransform;
 
 	vs_out.TexCoords = aTexCoords;
 
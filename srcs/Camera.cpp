@@ -38,8 +38,27 @@ Camera &Camera::operator=(Camera const &rhs) {
 	return *this;
 }
 
+/*
+same result as mat::lookAt(pos, pos + front) but written in one pass:
+front, right and up are already normalized by updateCameraVectors
+*/
 mat::Mat4 Camera::getViewMatrix() const {
-	return mat::lookAt(pos, pos + front);
+	mat::Mat4 view;
+	float *data = view.getData();
+
+	data[0] = right.x;
+	data[1] = right.y;
+	data[2] = right.z;
+	data[3] = -mat::dot(right, pos);
+	data[4] = up.x;
+	data[5] = up.y;
+	data[6] = up.z;
+	data[7] = -mat::dot(up, pos);
+	data[8] = -front.x;
+	data[9] = -front.y;
+	data[10] = -front.z;
+	data[11] = mat::dot(front, pos);
+	return view;
 }
 
 void Camera::processKeyboard(CamMovement direction, float dtTime) {
@@ -47,17 +66,17 @@ void Camera::processKeyboard(CamMovement direction, float dtTime) {
 
 	velocity = movementSpeed * dtTime;
 	if (direction == CamMovement::Forward)
-		pos = pos + front * velocity;
+		pos += front * velocity;
 	if (direction == CamMovement::Backward)
-		pos = pos - front * velocity;
+		pos -= front * velocity;
 	if (direction == CamMovement::Left)
-		pos = pos - right * velocity;
+		pos -= right * velocity;
 	if (direction == CamMovement::Right)
-		pos = pos + right * velocity;
+		pos += right * velocity;
 	if (direction == CamMovement::Up)
-		pos = pos + mat::Vec3(0, 1, 0) * velocity;
+		pos += mat::Vec3(0, 1, 0) * velocity;
 	if (direction == CamMovement::Down)
-		pos = pos - mat::Vec3(0, 1, 0) * velocity;
+		pos -= mat::Vec3(0, 1, 0) * velocity;
 }
 
 void Camera::processMouseMovement(float xOffset, float yOffset, bool constrainPitch) {
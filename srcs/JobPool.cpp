@@ -0,0 +1,78 @@
+#include "JobPool.hpp"
+
+JobPool::JobPool(u_int32_t nbWorkers)
+: _batch(0),
+  _nbBusyWorkers(0),
+  _stop(false),
+  _job(nullptr),
+  _count(0),
+  _next(0) {
+	for (u_int32_t i = 0; i < nbWorkers; ++i)
+		_workers.push_back(std::thread(&JobPool::workerLoop, this));
+}
+
+JobPool::~JobPool() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_startCond.notify_all();
+	for (auto &&worker : _workers)
+		worker.join();
+}
+
+void	JobPool::parallelFor(u_int32_t count, std::function<void(u_int32_t)> const &job) {
+	if (_workers.empty() || count < 2) {
+		for (u_int32_t i = 0; i < count; ++i)
+			job(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_job = &job;
+		_count = count;
+		_next = 0;
+		_nbBusyWorkers = _workers.size();
+		++_batch;
+	}
+	_startCond.notify_all();
+	runJobs();  // the calling thread works too
+
+	// wait for the workers: the last jobs can still be running
+	std::unique_lock<std::mutex> lock(_mutex);
+	_doneCond.wait(lock, [this]() { return _nbBusyWorkers == 0; });
+	_job = nullptr;
+}
+
+u_int32_t	JobPool::getNbWorkers() const { return _workers.size(); }
+
+u_int32_t	JobPool::defaultNbWorkers() {
+	u_int32_t nbCores = std::thread::hardware_concurrency();  // 0 if unknown
+	return (nbCores > 1) ? nbCores - 1 : 0;
+}
+
+void	JobPool::workerLoop() {
+	u_int64_t	lastBatch = 0;
+
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_startCond.wait(lock, [&]() { return _stop || _batch != lastBatch; });
+			if (_stop)
+				return;
+			lastBatch = _batch;
+		}
+		runJobs();
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			--_nbBusyWorkers;
+		}
+		_doneCond.notify_one();
+	}
+}
+
+void	JobPool::runJobs() {
+	for (u_int32_t i = _next++; i < _count; i = _next++)
+		(*_job)(i);
+}
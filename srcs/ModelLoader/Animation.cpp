@@ -0,0 +1,761 @@
+#include "Animation.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <utility>
+
+namespace {
+	void	interpolateVec3(mat::Vec3 &out, float time, const aiVectorKey *keys, u_int32_t nbKeys, \
+	u_int32_t &cursor) {
+		if (nbKeys == 1) {
+			out = aiToVec3(keys[0].mValue);
+			return;
+		}
+
+		float factor = keyFactor(time, keys, nbKeys, cursor);
+		const mat::Vec3 &start = aiToVec3(keys[cursor].mValue);
+		const mat::Vec3 &end = aiToVec3(keys[cursor + 1].mValue);
+		mat::Vec3 delta = end - start;
+		out = start + delta * factor;
+	}
+
+	void	interpolateQuat(mat::Quaternion &out, float time, const aiQuatKey *keys, u_int32_t nbKeys, \
+	u_int32_t &cursor) {
+		if (nbKeys == 1) {
+			out = aiToQuat(keys[0].mValue);
+			return;
+		}
+
+		float factor = keyFactor(time, keys, nbKeys, cursor);
+		const mat::Quaternion &startRotationQ = aiToQuat(keys[cursor].mValue);
+		const mat::Quaternion &endRotationQ = aiToQuat(keys[cursor + 1].mValue);
+		#if ROTATION_NLERP
+			out = mat::nlerp(startRotationQ, endRotationQ, factor);
+		#else
+			out = mat::slerp(startRotationQ, endRotationQ, factor);
+			out = out.normalize();
+		#endif
+	}
+
+	// angle between 2 rotations, from the vector part of conj(a) * b (precise for the small angles, unlike acos)
+	double	rotationAngle(const mat::Quaternion &a, const mat::Quaternion &b) {
+		double x = a.w * b.vec.x - b.w * a.vec.x - (a.vec.y * b.vec.z - a.vec.z * b.vec.y);
+		double y = a.w * b.vec.y - b.w * a.vec.y - (a.vec.z * b.vec.x - a.vec.x * b.vec.z);
+		double z = a.w * b.vec.z - b.w * a.vec.z - (a.vec.x * b.vec.y - a.vec.y * b.vec.x);
+		return 2 * std::asin(std::min(1.0, std::sqrt(x * x + y * y + z * z)));
+	}
+
+	// nlerp with the shortest path (used to decompress the rotations)
+	mat::Quaternion	nlerpShortest(const mat::Quaternion &a, const mat::Quaternion &b, float factor) {
+		float sign = (a.w * b.w + a.vec.x * b.vec.x + a.vec.y * b.vec.y + a.vec.z * b.vec.z < 0) ? -1.0f : 1.0f;
+		float fa = 1.0f - factor;
+		float fb = factor * sign;
+		float w = a.w * fa + b.w * fb;
+		float x = a.vec.x * fa + b.vec.x * fb;
+		float y = a.vec.y * fa + b.vec.y * fb;
+		float z = a.vec.z * fa + b.vec.z * fb;
+		float invLen = mat::math::invSqrt(w * w + x * x + y * y + z * z);
+		return mat::Quaternion(w * invLen, x * invLen, y * invLen, z * invLen);
+	}
+
+	float	axisValue(const aiVector3D &v, int axis) { return (axis == 0) ? v.x : ((axis == 1) ? v.y : v.z); }
+
+	float	maxAbs(const mat::Vec3 &v) { return std::max(std::fabs(v.x), std::max(std::fabs(v.y), std::fabs(v.z))); }
+
+	/*
+	max error of a clip compared to its source channels
+	checked on the keys, between the keys and every extraStep ticks (from extraStep / 2, 0 to disable)
+	sample(node, time, cursor, translation, rotation, scaling) -> transform of a node in the clip
+	*/
+	template<typename Sampler>
+	ClipError	measureError(std::vector<const aiNodeAnim*> const &channels, float duration, float extraStep, \
+	Sampler sample) {
+		ClipError	error;
+
+		for (u_int32_t i = 0; i < channels.size(); ++i) {
+			const aiNodeAnim *nodeAnim = channels[i];
+			if (!nodeAnim)
+				continue;
+			ChannelCursor	cursor;
+			ChannelCursor	clipCursor;
+			auto check = [&](float time) {
+				mat::Vec3		translation, clipTranslation;
+				mat::Quaternion	rotation, clipRotation;
+				mat::Vec3		scaling, clipScaling;
+				sampleChannel(nodeAnim, time, cursor, translation, rotation, scaling);
+				sample(i, time, clipCursor, clipTranslation, clipRotation, clipScaling);
+				mat::Vec3 dTranslation = clipTranslation - translation;
+				error.translation = std::max(error.translation, std::sqrt(dTranslation.dot(dTranslation)));
+				error.rotation = std::max(error.rotation, static_cast<float>(rotationAngle(rotation, clipRotation)));
+				error.scaling = std::max(error.scaling, maxAbs(clipScaling - scaling));
+			};
+			auto checkKeys = [&](const auto *keys, u_int32_t nbKeys) {
+				for (u_int32_t k = 0; k < nbKeys; ++k) {
+					check(keys[k].mTime);
+					if (k + 1 < nbKeys)
+						check((keys[k].mTime + keys[k + 1].mTime) / 2);
+				}
+			};
+			checkKeys(nodeAnim->mPositionKeys, nodeAnim->mNumPositionKeys);
+			checkKeys(nodeAnim->mRotationKeys, nodeAnim->mNumRotationKeys);
+			checkKeys(nodeAnim->mScalingKeys, nodeAnim->mNumScalingKeys);
+			for (float time = extraStep / 2; extraStep > 0 && time < duration; time += extraStep) {
+				check(time);
+			}
+		}
+		return error;
+	}
+}
+
+void	sampleChannel(const aiNodeAnim *nodeAnim, float time, ChannelCursor &cursor, \
+mat::Vec3 &translation, mat::Quaternion &rotation, mat::Vec3 &scaling) {
+	interpolateVec3(scaling, time, nodeAnim->mScalingKeys, nodeAnim->mNumScalingKeys, cursor.scaling);
+	interpolateQuat(rotation, time, nodeAnim->mRotationKeys, nodeAnim->mNumRotationKeys, cursor.rotation);
+	interpolateVec3(translation, time, nodeAnim->mPositionKeys, nodeAnim->mNumPositionKeys, cursor.position);
+}
+
+size_t	getKeysMemorySize(const aiNodeAnim *nodeAnim) {
+	return nodeAnim->mNumPositionKeys * sizeof(aiVectorKey) + nodeAnim->mNumRotationKeys * sizeof(aiQuatKey) \
+		+ nodeAnim->mNumScalingKeys * sizeof(aiVectorKey);
+}
+
+// exact comparison: the exporters write the same value in all the keys of a constant channel
+bool	isConstantChannel(const aiNodeAnim *nodeAnim) {
+	auto isConstant = [](auto const *keys, u_int32_t nbKeys) {
+		for (u_int32_t k = 1; k < nbKeys; ++k) {
+			if (!(keys[k].mValue == keys[0].mValue))
+				return false;
+		}
+		return true;
+	};
+	return isConstant(nodeAnim->mPositionKeys, nodeAnim->mNumPositionKeys) \
+		&& isConstant(nodeAnim->mRotationKeys, nodeAnim->mNumRotationKeys) \
+		&& isConstant(nodeAnim->mScalingKeys, nodeAnim->mNumScalingKeys);
+}
+
+/*
+--------------------------------------------------------------------------------
+TrackPose / TrackKeys
+*/
+void	TrackPose::set(u_int32_t track, mat::Vec3 const &translation, mat::Quaternion const &rotation, \
+mat::Vec3 const &scaling) {
+	get(TX)[track] = translation.x;
+	get(TY)[track] = translation.y;
+	get(TZ)[track] = translation.z;
+	get(RW)[track] = rotation.w;
+	get(RX)[track] = rotation.vec.x;
+	get(RY)[track] = rotation.vec.y;
+	get(RZ)[track] = rotation.vec.z;
+	get(SX)[track] = scaling.x;
+	get(SY)[track] = scaling.y;
+	get(SZ)[track] = scaling.z;
+}
+
+void	TrackKeys::resize(u_int32_t nbTracks) {
+	from.resize(nbTracks);
+	to.resize(nbTracks);
+	steps.resize(3 * nbTracks);
+}
+
+void	TrackKeys::interpolate(TrackPose &out) {
+	u_int32_t	nbTracks = from.getNbTracks();
+
+	out.resize(nbTracks);
+	for (int c = TrackPose::TX; c <= TrackPose::TZ; ++c)
+		mat::lerpBatch(from.get(c), to.get(c), steps.data() + TRANSLATION * nbTracks, out.get(c), nbTracks);
+	for (int c = TrackPose::SX; c <= TrackPose::SZ; ++c)
+		mat::lerpBatch(from.get(c), to.get(c), steps.data() + SCALING * nbTracks, out.get(c), nbTracks);
+	#if ROTATION_NLERP
+		mat::nlerpBatch(from.getRotations(), to.getRotations(), steps.data() + ROTATION * nbTracks, \
+			out.getRotations(), nbTracks);
+	#else
+		mat::slerpBatch(from.getRotations(), to.getRotations(), steps.data() + ROTATION * nbTracks, \
+			out.getRotations(), nbTracks);
+	#endif
+}
+
+/*
+--------------------------------------------------------------------------------
+KeyframeAnimation
+*/
+namespace {
+	float	*allocArena(u_int32_t size) {
+		if (size == 0)
+			return nullptr;
+		void *ptr = nullptr;
+		if (posix_memalign(&ptr, 32, size * sizeof(float)) != 0)
+			throw std::bad_alloc();
+		return static_cast<float*>(ptr);
+	}
+	u_int32_t	roundStride(u_int32_t nbKeys) { return (nbKeys + 7) & ~7u; }
+}
+
+KeyframeAnimation::KeyframeAnimation() : _size(0), _arena(nullptr) {}
+
+KeyframeAnimation::KeyframeAnimation(const aiAnimation *, std::vector<const aiNodeAnim*> const &channels)
+: _nodeTracks(channels.size(), -1),
+  _size(0),
+  _arena(nullptr) {
+	// layout of the arena: times + 3 or 4 values arrays per component
+	for (u_int32_t i = 0; i < channels.size(); ++i) {
+		const aiNodeAnim *nodeAnim = channels[i];
+		if (!nodeAnim)
+			continue;
+		Track		track;
+		u_int32_t	nbKeys[3] = {nodeAnim->mNumPositionKeys, nodeAnim->mNumRotationKeys, nodeAnim->mNumScalingKeys};
+		for (int c = 0; c < 3; ++c) {
+			track.offset[c] = _size;
+			track.nbKeys[c] = nbKeys[c];
+			track.stride[c] = roundStride(nbKeys[c]);
+			_size += track.stride[c] * ((c == ROTATION) ? 5 : 4);
+		}
+		_nodeTracks[i] = _tracks.size();
+		_tracks.push_back(track);
+	}
+
+	_arena = allocArena(_size);
+	std::fill(_arena, _arena + _size, 0.0f);  // padding
+	for (u_int32_t i = 0; i < channels.size(); ++i) {
+		const aiNodeAnim *nodeAnim = channels[i];
+		if (!nodeAnim)
+			continue;
+		const Track	&track = _tracks[_nodeTracks[i]];
+		const aiVectorKey *vecKeys[3] = {nodeAnim->mPositionKeys, nullptr, nodeAnim->mScalingKeys};
+		for (int c = 0; c < 3; ++c) {
+			float		*times = _arena + track.offset[c];
+			u_int32_t	stride = track.stride[c];
+			for (u_int32_t k = 0; k < track.nbKeys[c]; ++k) {
+				if (c == ROTATION) {
+					const aiQuatKey &key = nodeAnim->mRotationKeys[k];
+					times[k] = keyTime(key);
+					times[stride + k] = key.mValue.w;
+					times[2 * stride + k] = key.mValue.x;
+					times[3 * stride + k] = key.mValue.y;
+					times[4 * stride + k] = key.mValue.z;
+				}
+				else {
+					const aiVectorKey &key = vecKeys[c][k];
+					times[k] = keyTime(key);
+					times[stride + k] = key.mValue.x;
+					times[2 * stride + k] = key.mValue.y;
+					times[3 * stride + k] = key.mValue.z;
+				}
+			}
+		}
+	}
+}
+
+KeyframeAnimation::KeyframeAnimation(KeyframeAnimation const &src) : _size(0), _arena(nullptr) {
+	*this = src;
+}
+
+KeyframeAnimation::KeyframeAnimation(KeyframeAnimation &&src) : _size(0), _arena(nullptr) {
+	*this = std::move(src);
+}
+
+KeyframeAnimation::~KeyframeAnimation() {
+	free(_arena);
+}
+
+KeyframeAnimation &KeyframeAnimation::operator=(KeyframeAnimation const &rhs) {
+	if (this != &rhs) {
+		float *arena = allocArena(rhs._size);
+		std::copy(rhs._arena, rhs._arena + rhs._size, arena);
+		free(_arena);
+		_arena = arena;
+		_size = rhs._size;
+		_nodeTracks = rhs._nodeTracks;
+		_tracks = rhs._tracks;
+	}
+	return *this;
+}
+
+KeyframeAnimation &KeyframeAnimation::operator=(KeyframeAnimation &&rhs) {
+	if (this != &rhs) {
+		std::swap(_arena, rhs._arena);
+		std::swap(_size, rhs._size);
+		_nodeTracks = std::move(rhs._nodeTracks);
+		_tracks = std::move(rhs._tracks);
+	}
+	return *this;
+}
+
+size_t	KeyframeAnimation::getMemorySize() const {
+	return _size * sizeof(float) + _tracks.size() * sizeof(Track) + _nodeTracks.size() * sizeof(int);
+}
+
+void	KeyframeAnimation::interpolateVec3(float time, const Track &track, int component, u_int32_t &cursor, \
+mat::Vec3 &out) const {
+	const float	*times = _arena + track.offset[component];
+	u_int32_t	stride = track.stride[component];
+	const float	*x = times + stride;
+	const float	*y = x + stride;
+	const float	*z = y + stride;
+
+	if (track.nbKeys[component] == 1) {
+		out = mat::Vec3(x[0], y[0], z[0]);
+		return;
+	}
+	float factor = keyFactor(time, times, track.nbKeys[component], cursor);
+	const mat::Vec3 start(x[cursor], y[cursor], z[cursor]);
+	const mat::Vec3 end(x[cursor + 1], y[cursor + 1], z[cursor + 1]);
+	mat::Vec3 delta = end - start;
+	out = start + delta * factor;
+}
+
+void	KeyframeAnimation::sample(float time, int track, ChannelCursor &cursor, mat::Vec3 &translation, \
+mat::Quaternion &rotation, mat::Vec3 &scaling) const {
+	const Track	&tr = _tracks[track];
+
+	interpolateVec3(time, tr, SCALING, cursor.scaling, scaling);
+
+	const float	*times = _arena + tr.offset[ROTATION];
+	u_int32_t	stride = tr.stride[ROTATION];
+	const float	*w = times + stride;
+	const float	*x = w + stride;
+	const float	*y = x + stride;
+	const float	*z = y + stride;
+	if (tr.nbKeys[ROTATION] == 1) {
+		rotation = mat::Quaternion(w[0], x[0], y[0], z[0]);
+	}
+	else {
+		float factor = keyFactor(time, times, tr.nbKeys[ROTATION], cursor.rotation);
+		u_int32_t k = cursor.rotation;
+		const mat::Quaternion start(w[k], x[k], y[k], z[k]);
+		const mat::Quaternion end(w[k + 1], x[k + 1], y[k + 1], z[k + 1]);
+		#if ROTATION_NLERP
+			rotation = mat::nlerp(start, end, factor);
+		#else
+			rotation = mat::slerp(start, end, factor);
+			rotation = rotation.normalize();
+		#endif
+	}
+
+	interpolateVec3(time, tr, TRANSLATION, cursor.position, translation);
+}
+
+void	KeyframeAnimation::findKeys(float time, int track, ChannelCursor &cursor, TrackKeys &keys) const {
+	const Track	&tr = _tracks[track];
+	u_int32_t	*cursors[3] = {&cursor.position, &cursor.rotation, &cursor.scaling};
+	const int	firstComponent[3] = {TrackPose::TX, TrackPose::RW, TrackPose::SX};  // the rotation is w x y z
+	u_int32_t	nbTracks = keys.from.getNbTracks();
+
+	for (int c = 0; c < 3; ++c) {
+		const float	*times = _arena + tr.offset[c];
+		u_int32_t	stride = tr.stride[c];
+		u_int32_t	key = 0;
+		u_int32_t	next = 0;
+		float		factor = 0;
+		if (tr.nbKeys[c] > 1) {
+			factor = keyFactor(time, times, tr.nbKeys[c], *cursors[c]);
+			key = *cursors[c];
+			next = key + 1;
+		}
+		for (int v = 0; v < ((c == ROTATION) ? 4 : 3); ++v) {
+			keys.from.get(firstComponent[c] + v)[track] = times[(v + 1) * stride + key];
+			keys.to.get(firstComponent[c] + v)[track] = times[(v + 1) * stride + next];
+		}
+		keys.steps[c * nbTracks + track] = factor;
+	}
+}
+
+/*
+--------------------------------------------------------------------------------
+BakedAnimation
+*/
+BakedAnimation::BakedAnimation() : _nbTracks(0), _nbFrames(0), _framesPerTick(0) {}
+
+BakedAnimation::BakedAnimation(const aiAnimation *animation, std::vector<const aiNodeAnim*> const &channels, \
+float rate)
+: _nodeTracks(channels.size(), -1),
+  _nbTracks(0),
+  _nbFrames(1),
+  _framesPerTick(0) {
+	for (u_int32_t i = 0; i < channels.size(); ++i) {
+		if (channels[i])
+			_nodeTracks[i] = _nbTracks++;
+	}
+
+	// the frames are spread on the whole animation (the real rate is a bit higher than rate)
+	float ticksPerSecond = (animation->mTicksPerSecond != 0) ? animation->mTicksPerSecond : 25.0f;
+	float duration = animation->mDuration;
+	if (duration > 0 && rate > 0) {
+		_nbFrames = std::max(2, static_cast<int>(std::ceil(duration / ticksPerSecond * rate)) + 1);
+		_framesPerTick = (_nbFrames - 1) / duration;
+	}
+
+	_data.resize(TrackPose::NB_COMPONENTS * _nbFrames * _nbTracks);
+	for (u_int32_t i = 0; i < channels.size(); ++i) {
+		if (!channels[i])
+			continue;
+		ChannelCursor	cursor;
+		mat::Vec3		translation;
+		mat::Quaternion	rotation;
+		mat::Vec3		scaling;
+		for (u_int32_t frame = 0; frame < _nbFrames; ++frame) {
+			float time = (_nbFrames > 1) ? frame * duration / (_nbFrames - 1) : 0.0f;
+			sampleChannel(channels[i], time, cursor, translation, rotation, scaling);
+			setFrame(frame, _nodeTracks[i], translation, rotation, scaling);
+		}
+	}
+	// the error is the biggest between the frames
+	_maxError = measureError(channels, duration, (_framesPerTick > 0) ? 1 / _framesPerTick : 0, \
+		[this](u_int32_t node, float time, ChannelCursor &, mat::Vec3 &translation, mat::Quaternion &rotation, \
+		mat::Vec3 &scaling) { sample(time, _nodeTracks[node], translation, rotation, scaling); });
+}
+
+void	BakedAnimation::setFrame(u_int32_t frame, int track, mat::Vec3 const &translation, \
+mat::Quaternion rotation, mat::Vec3 const &scaling) {
+	size_t	stride = _nbFrames * _nbTracks;  // between 2 components
+	float	*data = &_data[frame * _nbTracks + track];
+
+	// same hemisphere as the previous frame -> sample can interpolate without checking the sign
+	if (frame > 0) {
+		const float *prev = data - _nbTracks;
+		float dot = prev[TrackPose::RW * stride] * rotation.w + prev[TrackPose::RX * stride] * rotation.vec.x \
+			+ prev[TrackPose::RY * stride] * rotation.vec.y \
+			+ prev[TrackPose::RZ * stride] * rotation.vec.z;
+		if (dot < 0)
+			rotation = mat::Quaternion(-rotation.w, -rotation.vec.x, -rotation.vec.y, -rotation.vec.z);
+	}
+	data[TrackPose::TX * stride] = translation.x;
+	data[TrackPose::TY * stride] = translation.y;
+	data[TrackPose::TZ * stride] = translation.z;
+	data[TrackPose::RW * stride] = rotation.w;
+	data[TrackPose::RX * stride] = rotation.vec.x;
+	data[TrackPose::RY * stride] = rotation.vec.y;
+	data[TrackPose::RZ * stride] = rotation.vec.z;
+	data[TrackPose::SX * stride] = scaling.x;
+	data[TrackPose::SY * stride] = scaling.y;
+	data[TrackPose::SZ * stride] = scaling.z;
+}
+
+void	BakedAnimation::sample(float time, int track, mat::Vec3 &translation, mat::Quaternion &rotation, \
+mat::Vec3 &scaling) const {
+	float		pos = std::min(std::max(time * _framesPerTick, 0.0f), static_cast<float>(_nbFrames - 1));
+	u_int32_t	frame = static_cast<u_int32_t>(pos);
+	u_int32_t	next = std::min(frame + 1, _nbFrames - 1);
+	float		factor = pos - frame;
+	size_t		stride = _nbFrames * _nbTracks;
+	const float	*a = &_data[frame * _nbTracks + track];
+	const float	*b = &_data[next * _nbTracks + track];
+
+	auto lerp = [&](int c) { return a[c * stride] + (b[c * stride] - a[c * stride]) * factor; };
+	translation = mat::Vec3(lerp(TrackPose::TX), lerp(TrackPose::TY), lerp(TrackPose::TZ));
+	scaling = mat::Vec3(lerp(TrackPose::SX), lerp(TrackPose::SY), lerp(TrackPose::SZ));
+	// nlerp, the 2 frames are close and in the same hemisphere
+	float w = lerp(TrackPose::RW), x = lerp(TrackPose::RX);
+	float y = lerp(TrackPose::RY), z = lerp(TrackPose::RZ);
+	float invLen = mat::math::invSqrt(w * w + x * x + y * y + z * z);
+	rotation = mat::Quaternion(w * invLen, x * invLen, y * invLen, z * invLen);
+}
+
+void	BakedAnimation::sampleTracks(float time, TrackPose &pose) const {
+	float		pos = std::min(std::max(time * _framesPerTick, 0.0f), static_cast<float>(_nbFrames - 1));
+	u_int32_t	frame = static_cast<u_int32_t>(pos);
+	u_int32_t	next = std::min(frame + 1, _nbFrames - 1);
+	float		factor = pos - frame;
+	size_t		stride = _nbFrames * _nbTracks;
+
+	pose.resize(_nbTracks);
+	if (_nbTracks == 0)
+		return;
+	// the tracks of a frame are contiguous: one lerp per component for all the tracks
+	for (int c = 0; c < TrackPose::NB_COMPONENTS; ++c) {
+		mat::lerpBatch(&_data[c * stride + frame * _nbTracks], &_data[c * stride + next * _nbTracks], factor, \
+			pose.get(c), _nbTracks);
+	}
+	mat::normalizeBatch(pose.getRotations(), pose.getRotations(), _nbTracks);
+}
+
+size_t	BakedAnimation::getMemorySize() const {
+	return _data.size() * sizeof(float) + _nodeTracks.size() * sizeof(int);
+}
+
+/*
+--------------------------------------------------------------------------------
+CompressedAnimation
+*/
+namespace {
+	const float	QUAT_RANGE = 0.70710678f;  // the 3 smallest components are in [-1/sqrt(2), 1/sqrt(2)]
+	const u_int32_t	MAX_REMOVED_KEYS = 256;  // keys removed in a row, limits the reduction to O(n * MAX_REMOVED_KEYS)
+	const u_int32_t	MAX_SPLIT_KEYS = 64;  // keys added between 2 rotation keys (see splitRotationKeys)
+	// where the interpolation is checked between 2 keys (nlerp and slerp are equal in the middle, not around the quarters)
+	const u_int32_t	NB_CHECKS = 8;
+	const float		CHECK_MARGIN = 0.95f;  // part of the tolerance used on the checks (the error can be higher between them)
+
+	void	encodeQuat(mat::Quaternion q, u_int16_t out[3]) {
+		q = q.normalize();
+		float	c[4] = {q.w, q.vec.x, q.vec.y, q.vec.z};
+		int		largest = 0;
+		for (int i = 1; i < 4; ++i) {
+			if (std::fabs(c[i]) > std::fabs(c[largest]))
+				largest = i;
+		}
+		float sign = (c[largest] < 0) ? -1.0f : 1.0f;  // q and -q are the same rotation -> the largest is positive
+		for (int i = 0, j = 0; i < 4; ++i) {
+			if (i == largest)
+				continue;
+			float v = std::min(std::max(c[i] * sign / QUAT_RANGE * 0.5f + 0.5f, 0.0f), 1.0f);
+			out[j++] = static_cast<u_int16_t>(std::lround(v * 0x7fff));
+		}
+		out[0] |= (largest & 1) << 15;
+		out[1] |= (largest >> 1) << 15;
+	}
+
+	mat::Quaternion	decodeQuat(const u_int16_t in[3]) {
+		int		largest = (in[0] >> 15) | ((in[1] >> 15) << 1);
+		float	c[4];
+		float	sum = 0;
+		for (int i = 0, j = 0; i < 4; ++i) {
+			if (i == largest)
+				continue;
+			c[i] = ((in[j++] & 0x7fff) * (2.0f / 0x7fff) - 1.0f) * QUAT_RANGE;
+			sum += c[i] * c[i];
+		}
+		c[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+		return mat::Quaternion(c[0], c[1], c[2], c[3]);
+	}
+
+	/*
+	the decoder uses nlerp, the source can use slerp (ROTATION_NLERP): between 2 keys far apart, the difference
+	is above the tolerance even if no key is removed -> the interval is split in 2, 4, 8... keys sampled in the source
+	until the nlerp of each part is within tolerance / 2 (the other half for the quantization and the reduction)
+	*/
+	std::vector<aiQuatKey>	splitRotationKeys(const aiQuatKey *keys, u_int32_t nbKeys, float tolerance) {
+		std::vector<aiQuatKey>	res;
+		u_int32_t				cursor = 0;
+
+		auto sampleKey = [&](double time) {
+			mat::Quaternion q;
+			interpolateQuat(q, time, keys, nbKeys, cursor);
+			aiQuatKey key;
+			key.mTime = time;
+			key.mValue = aiQuaternion(q.w, q.vec.x, q.vec.y, q.vec.z);
+			return key;
+		};
+		for (u_int32_t k = 0; k + 1 < nbKeys; ++k) {
+			double		start = keys[k].mTime;
+			double		deltaTime = keys[k + 1].mTime - start;
+			u_int32_t	nbParts = 1;
+			for (; nbParts < MAX_SPLIT_KEYS && deltaTime > 0; nbParts *= 2) {
+				bool valid = true;
+				for (u_int32_t part = 0; part < nbParts && valid; ++part) {
+					mat::Quaternion a = aiToQuat(sampleKey(start + deltaTime * part / nbParts).mValue).normalize();
+					mat::Quaternion b = aiToQuat(sampleKey(start + deltaTime * (part + 1) / nbParts).mValue).normalize();
+					for (u_int32_t check = 1; check < NB_CHECKS; ++check) {
+						float factor = static_cast<float>(check) / NB_CHECKS;
+						mat::Quaternion q = aiToQuat(sampleKey(start + deltaTime * (part + factor) / nbParts).mValue);
+						valid = valid && rotationAngle(nlerpShortest(a, b, factor), q.normalize()) <= tolerance / 2;
+					}
+				}
+				if (valid)
+					break;
+			}
+			res.push_back(keys[k]);
+			for (u_int32_t part = 1; part < nbParts; ++part)
+				res.push_back(sampleKey(start + deltaTime * part / nbParts));
+		}
+		if (nbKeys > 0)
+			res.push_back(keys[nbKeys - 1]);
+		return res;
+	}
+
+	/*
+	indexes of the keys kept: the keys between two kept keys are removed when the segment is valid
+	valid(start, end) -> the interpolation between the keys start and end reproduces the source within the tolerance
+	(the first and the last keys are always kept)
+	*/
+	template<typename Valid>
+	std::vector<u_int32_t>	reduceKeys(u_int32_t nbKeys, Valid valid) {
+		std::vector<u_int32_t>	kept(1, 0);
+		u_int32_t				start = 0;
+
+		for (u_int32_t end = 2; end < nbKeys; ++end) {
+			if (end - start > MAX_REMOVED_KEYS || !valid(start, end)) {
+				start = end - 1;
+				kept.push_back(start);
+			}
+		}
+		if (nbKeys > 1)
+			kept.push_back(nbKeys - 1);
+		return kept;
+	}
+
+	/*
+	segment of quantized keys checked against the source keys: on the source keys between start and end
+	and on NB_CHECKS points of each interval
+	sampleSource(time, cursor) -> source value, interpolate(factor) -> value between the decoded keys
+	error(source, value) -> compared to tolerance * CHECK_MARGIN
+	*/
+	template<typename Key, typename SampleSource, typename Interpolate, typename Error>
+	bool	isValidSegment(const Key *keys, QuantizedKey const &start, QuantizedKey const &end, float timeScale, \
+	u_int32_t startIndex, u_int32_t endIndex, float tolerance, SampleSource sampleSource, Interpolate interpolate, \
+	Error error) {
+		QuantizedKey	segment[2] = {start, end};
+		u_int32_t		cursor = 0;
+		u_int32_t		segmentCursor = 0;
+
+		for (u_int32_t k = startIndex; k < endIndex; ++k) {
+			for (u_int32_t check = 0; check < NB_CHECKS; ++check) {
+				float time = keys[k].mTime + (keys[k + 1].mTime - keys[k].mTime) * check / NB_CHECKS;
+				float factor = keyFactor(time * timeScale, segment, 2, segmentCursor);
+				if (error(sampleSource(time, cursor), interpolate(factor)) > tolerance * CHECK_MARGIN)
+					return false;
+			}
+		}
+		return true;
+	}
+}
+
+CompressedAnimation::CompressedAnimation() : _timeScale(0), _sourceSize(0) {}
+
+/*
+the keys are quantized before the reduction: the removed keys are checked against the decoded keys,
+so the error of the quantization (time and value) is in the tolerance
+*/
+CompressedAnimation::CompressedAnimation(const aiAnimation *animation, \
+std::vector<const aiNodeAnim*> const &channels, ClipError const &tolerance)
+: _nodeTracks(channels.size(), -1),
+  _timeScale((animation->mDuration > 0) ? 65535 / animation->mDuration : 0),
+  _sourceSize(0) {
+	auto quantizeTime = [this](double time) {
+		return static_cast<u_int16_t>(std::lround(std::min(std::max(time * _timeScale, 0.0), 65535.0)));
+	};
+	auto vec3Error = [](const mat::Vec3 &source, const mat::Vec3 &value) {
+		mat::Vec3 d = value - source;
+		return std::sqrt(d.dot(d));
+	};
+	auto scalingError = [](const mat::Vec3 &source, const mat::Vec3 &value) { return maxAbs(value - source); };
+	auto quatError = [](const mat::Quaternion &source, const mat::Quaternion &value) {
+		return static_cast<float>(rotationAngle(source, value));
+	};
+	// translation and scaling: quantized in the range of the track
+	auto addVec3Keys = [&](Track &track, int component, int range, const aiVectorKey *keys, u_int32_t nbKeys, \
+	float maxError, auto error) {
+		float min[3], max[3];
+		for (int axis = 0; axis < 3; ++axis) {
+			min[axis] = std::numeric_limits<float>::max();
+			max[axis] = std::numeric_limits<float>::lowest();
+			for (u_int32_t k = 0; k < nbKeys; ++k) {
+				min[axis] = std::min(min[axis], axisValue(keys[k].mValue, axis));
+				max[axis] = std::max(max[axis], axisValue(keys[k].mValue, axis));
+			}
+			track.min[range][axis] = min[axis];
+			track.step[range][axis] = (max[axis] - min[axis]) / 65535;
+		}
+		std::vector<QuantizedKey>	quantized(nbKeys);
+		for (u_int32_t k = 0; k < nbKeys; ++k) {
+			quantized[k].mTime = quantizeTime(keys[k].mTime);
+			for (int axis = 0; axis < 3; ++axis) {
+				float scale = (max[axis] > min[axis]) ? 65535 / (max[axis] - min[axis]) : 0;
+				quantized[k].value[axis] = static_cast<u_int16_t>(std::lround((axisValue(keys[k].mValue, axis) \
+					- min[axis]) * scale));
+			}
+		}
+		auto decode = [&track, range](const QuantizedKey &key) { return decodeVec3(track, key, range); };
+		std::vector<u_int32_t> kept = reduceKeys(nbKeys, [&](u_int32_t start, u_int32_t end) {
+			mat::Vec3 a = decode(quantized[start]);
+			mat::Vec3 b = decode(quantized[end]);
+			return isValidSegment(keys, quantized[start], quantized[end], _timeScale, start, end, maxError, \
+				[&](float time, u_int32_t &cursor) {
+					mat::Vec3 value;
+					interpolateVec3(value, time, keys, nbKeys, cursor);
+					return value;
+				},
+				[&](float factor) { return a + (b - a) * factor; }, error);
+		});
+		track.first[component] = _keys.size();
+		track.nbKeys[component] = kept.size();
+		for (u_int32_t k : kept)
+			_keys.push_back(quantized[k]);
+	};
+
+	for (u_int32_t i = 0; i < channels.size(); ++i) {
+		const aiNodeAnim *nodeAnim = channels[i];
+		if (!nodeAnim)
+			continue;
+		_sourceSize += getKeysMemorySize(nodeAnim);
+		_nodeTracks[i] = _tracks.size();
+
+		Track track;
+		addVec3Keys(track, 0, 0, nodeAnim->mPositionKeys, nodeAnim->mNumPositionKeys, tolerance.translation, \
+			vec3Error);
+		addVec3Keys(track, 2, 1, nodeAnim->mScalingKeys, nodeAnim->mNumScalingKeys, tolerance.scaling, scalingError);
+
+		// rotation: the reduction is on the split keys, checked against the source keys
+		const aiQuatKey				*sourceKeys = nodeAnim->mRotationKeys;
+		u_int32_t					nbSourceKeys = nodeAnim->mNumRotationKeys;
+		std::vector<aiQuatKey>		keys = splitRotationKeys(sourceKeys, nbSourceKeys, tolerance.rotation);
+		std::vector<QuantizedKey>	quantized(keys.size());
+		for (u_int32_t k = 0; k < keys.size(); ++k) {
+			quantized[k].mTime = quantizeTime(keys[k].mTime);
+			encodeQuat(aiToQuat(keys[k].mValue), quantized[k].value);
+		}
+		std::vector<u_int32_t> kept = reduceKeys(keys.size(), [&](u_int32_t start, u_int32_t end) {
+			mat::Quaternion a = decodeQuat(quantized[start].value);
+			mat::Quaternion b = decodeQuat(quantized[end].value);
+			return isValidSegment(keys.data(), quantized[start], quantized[end], _timeScale, start, end, \
+				tolerance.rotation, [&](float time, u_int32_t &cursor) {
+					mat::Quaternion value;
+					interpolateQuat(value, time, sourceKeys, nbSourceKeys, cursor);
+					return value;
+				},
+				[&](float factor) { return nlerpShortest(a, b, factor); }, quatError);
+		});
+		track.first[1] = _keys.size();
+		track.nbKeys[1] = kept.size();
+		for (u_int32_t k : kept)
+			_keys.push_back(quantized[k]);
+		_tracks.push_back(track);
+	}
+
+	_maxError = measureError(channels, animation->mDuration, 0, [this](u_int32_t node, float time, \
+		ChannelCursor &cursor, mat::Vec3 &translation, mat::Quaternion &rotation, mat::Vec3 &scaling) {
+		sample(time, _nodeTracks[node], cursor, translation, rotation, scaling);
+	});
+}
+
+mat::Vec3	CompressedAnimation::decodeVec3(Track const &track, QuantizedKey const &key, int range) {
+	return mat::Vec3(track.min[range][0] + key.value[0] * track.step[range][0], \
+		track.min[range][1] + key.value[1] * track.step[range][1], track.min[range][2] + key.value[2] * track.step[range][2]);
+}
+
+void	CompressedAnimation::sample(float time, int track, ChannelCursor &cursor, mat::Vec3 &translation, \
+mat::Quaternion &rotation, mat::Vec3 &scaling) const {
+	const Track	&tr = _tracks[track];
+	float		qTime = time * _timeScale;
+
+	auto interpolateKeys = [&](int component, int range, u_int32_t &keyCursor) {
+		const QuantizedKey *keys = &_keys[tr.first[component]];
+		if (tr.nbKeys[component] == 1)
+			return decodeVec3(tr, keys[0], range);
+		float factor = keyFactor(qTime, keys, tr.nbKeys[component], keyCursor);
+		mat::Vec3 start = decodeVec3(tr, keys[keyCursor], range);
+		return start + (decodeVec3(tr, keys[keyCursor + 1], range) - start) * factor;
+	};
+
+	translation = interpolateKeys(0, 0, cursor.position);
+	scaling = interpolateKeys(2, 1, cursor.scaling);
+
+	const QuantizedKey *keys = &_keys[tr.first[1]];
+	if (tr.nbKeys[1] == 1) {
+		rotation = decodeQuat(keys[0].value);
+	}
+	else {
+		float factor = keyFactor(qTime, keys, tr.nbKeys[1], cursor.rotation);
+		rotation = nlerpShortest(decodeQuat(keys[cursor.rotation].value), decodeQuat(keys[cursor.rotation + 1].value), \
+			factor);
+	}
+}
+
+size_t	CompressedAnimation::getMemorySize() const {
+	return _keys.size() * sizeof(QuantizedKey) + _tracks.size() * sizeof(Track) + _nodeTracks.size() * sizeof(int);
+}
+
+float	CompressedAnimation::getCompressionRatio() const {
+	size_t size = getMemorySize();
+	return (size > 0) ? static_cast<float>(_sourceSize) / size : 0;
+}
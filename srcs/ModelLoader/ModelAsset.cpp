@@ -0,0 +1,692 @@
+#include "ModelAsset.hpp"
+#include "Pose.hpp"
+#include <limits>
+
+std::map<std::string, std::weak_ptr<const ModelAsset> >	ModelAsset::_cache;
+std::mutex	ModelAsset::_cacheMutex;
+
+
+// 36 vertices: built at compile time, the number of values is checked by the compiler
+const mat::Matrix<36, 8>	ModelAsset::_cubeData(
+	// positions			// normals				// texture coords
+	-0.5f, -0.5f, -0.5f,	0.0f, 0.0f, -1.0f,		0.0f, 0.0f,
+	0.5f, -0.5f, -0.5f,		0.0f, 0.0f, -1.0f,		1.0f, 0.0f,
+	0.5f, 0.5f, -0.5f,		0.0f, 0.0f, -1.0f,		1.0f, 1.0f,
+	0.5f, 0.5f, -0.5f,		0.0f, 0.0f, -1.0f,		1.0f, 1.0f,
+	-0.5f, 0.5f, -0.5f,		0.0f, 0.0f, -1.0f,		0.0f, 1.0f,
+	-0.5f, -0.5f, -0.5f,	0.0f, 0.0f, -1.0f,		0.0f, 0.0f,
+	-0.5f, -0.5f, 0.5f,		0.0f, 0.0f, 1.0f,		0.0f, 0.0f,
+	0.5f, -0.5f, 0.5f,		0.0f, 0.0f, 1.0f,		1.0f, 0.0f,
+	0.5f, 0.5f, 0.5f,		0.0f, 0.0f, 1.0f,		1.0f, 1.0f,
+	0.5f, 0.5f, 0.5f,		0.0f, 0.0f, 1.0f,		1.0f, 1.0f,
+	-0.5f, 0.5f, 0.5f,		0.0f, 0.0f, 1.0f,		0.0f, 1.0f,
+	-0.5f, -0.5f, 0.5f,		0.0f, 0.0f, 1.0f,		0.0f, 0.0f,
+	-0.5f, 0.5f, 0.5f,		-1.0f, 0.0f, 0.0f,		1.0f, 0.0f,
+	-0.5f, 0.5f, -0.5f,		-1.0f, 0.0f, 0.0f,		1.0f, 1.0f,
+	-0.5f, -0.5f, -0.5f,	-1.0f, 0.0f, 0.0f,		0.0f, 1.0f,
+	-0.5f, -0.5f, -0.5f,	-1.0f, 0.0f, 0.0f,		0.0f, 1.0f,
+	-0.5f, -0.5f, 0.5f,		-1.0f, 0.0f, 0.0f,		0.0f, 0.0f,
+	-0.5f, 0.5f, 0.5f,		-1.0f, 0.0f, 0.0f,		1.0f, 0.0f,
+	0.5f, 0.5f, 0.5f,		1.0f, 0.0f, 0.0f,		1.0f, 0.0f,
+	0.5f, 0.5f, -0.5f,		1.0f, 0.0f, 0.0f,		1.0f, 1.0f,
+	0.5f, -0.5f, -0.5f,		1.0f, 0.0f, 0.0f,		0.0f, 1.0f,
+	0.5f, -0.5f, -0.5f,		1.0f, 0.0f, 0.0f,		0.0f, 1.0f,
+	0.5f, -0.5f, 0.5f,		1.0f, 0.0f, 0.0f,		0.0f, 0.0f,
+	0.5f, 0.5f, 0.5f,		1.0f, 0.0f, 0.0f,		1.0f, 0.0f,
+	-0.5f, -0.5f, -0.5f,	0.0f, -1.0f, 0.0f,		0.0f, 1.0f,
+	0.5f, -0.5f, -0.5f,		0.0f, -1.0f, 0.0f,		1.0f, 1.0f,
+	0.5f, -0.5f, 0.5f,		0.0f, -1.0f, 0.0f,		1.0f, 0.0f,
+	0.5f, -0.5f, 0.5f,		0.0f, -1.0f, 0.0f,		1.0f, 0.0f,
+	-0.5f, -0.5f, 0.5f,		0.0f, -1.0f, 0.0f,		0.0f, 0.0f,
+	-0.5f, -0.5f, -0.5f,	0.0f, -1.0f, 0.0f,		0.0f, 1.0f,
+	-0.5f, 0.5f, -0.5f,		0.0f, 1.0f, 0.0f,		0.0f, 1.0f,
+	0.5f, 0.5f, -0.5f,		0.0f, 1.0f, 0.0f,		1.0f, 1.0f,
+	0.5f, 0.5f, 0.5f,		0.0f, 1.0f, 0.0f,		1.0f, 0.0f,
+	0.5f, 0.5f, 0.5f,		0.0f, 1.0f, 0.0f,		1.0f, 0.0f,
+	-0.5f, 0.5f, 0.5f,		0.0f, 1.0f, 0.0f,		0.0f, 0.0f,
+	-0.5f, 0.5f, -0.5f,		0.0f, 1.0f, 0.0f,		0.0f, 1.0f
+);
+
+
+std::shared_ptr<const ModelAsset>	ModelAsset::load(std::string const &path, bool withGpu) {
+	std::lock_guard<std::mutex>	lock(_cacheMutex);
+	std::string					key = (withGpu ? "" : "headless:") + path;
+
+	std::shared_ptr<const ModelAsset> asset = _cache[key].lock();
+	if (!asset) {
+		asset = std::shared_ptr<const ModelAsset>(new ModelAsset(path, withGpu));
+		_cache[key] = asset;
+	}
+	return asset;
+}
+
+// assets used by at least one Model
+u_int32_t	ModelAsset::getNbLoadedAssets() {
+	std::lock_guard<std::mutex>	lock(_cacheMutex);
+	u_int32_t					nbAssets = 0;
+	for (auto it = _cache.begin(); it != _cache.end(); ) {
+		if (it->second.expired()) {
+			it = _cache.erase(it);
+		}
+		else {
+			++nbAssets;
+			++it;
+		}
+	}
+	return nbAssets;
+}
+
+ModelAsset::ModelAsset(std::string const &path, bool withGpu)
+: _path(path),
+  _withGpu(withGpu),
+  _minPos(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()),
+  _maxPos(std::numeric_limits<float>::min(), std::numeric_limits<float>::min(), std::numeric_limits<float>::min()),
+  _bonePosUniform{0},
+  _nbInvalidChannels(0),
+  _scene(nullptr),
+  _cubeVbo(0),
+  _cubeVao(0) {
+	loadModel(path);
+	if (_withGpu)
+		sendCubeData();
+}
+
+ModelAsset::~ModelAsset() {
+	if (!_withGpu)
+		return;
+	for (auto &&mesh : _meshes) {
+		u_int32_t vao = mesh.getVao();
+		u_int32_t buffers[2] = {mesh.getVbo(), mesh.getEbo()};
+		glDeleteVertexArrays(1, &vao);
+		glDeleteBuffers(2, buffers);
+	}
+	for (auto &&texture : _texturesLoaded)
+		glDeleteTextures(1, &texture.id);
+	glDeleteVertexArrays(1, &_cubeVao);
+	glDeleteBuffers(1, &_cubeVbo);
+}
+
+void	ModelAsset::loadModel(std::string const &path) {
+	_scene = _importer.ReadFile(path, \
+	aiProcess_Triangulate | \
+	aiProcess_FlipUVs | \
+	aiProcess_GenNormals | \
+	aiProcess_GenUVCoords | \
+	aiProcess_LimitBoneWeights | \
+	aiProcess_CalcTangentSpace);
+
+	if (!_scene || _scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !_scene->mRootNode) {
+		std::cerr << "ERROR::ASSIMP::" << _importer.GetErrorString() << std::endl;
+		throw ModelAsset::AssimpError();
+	}
+	_directory = path.substr(0, path.find_last_of('/'));
+
+	_globalTransform = mat::Affine(aiToMat4(_scene->mRootNode->mTransformation));  // get global transform
+	_globalInverseTransform = _globalTransform;
+
+	processNode(_scene->mRootNode, _scene);
+	// the bones are known after processNode
+	_skeleton.clear();
+	loadSkeleton(_scene->mRootNode, -1);
+	sortSkeletonLevels();
+	_nbInvalidChannels = 0;
+	for (u_int32_t i = 0; i < _scene->mNumAnimations; ++i) {
+		for (u_int32_t j = 0; j < _scene->mAnimations[i]->mNumChannels; ++j) {
+			if (!isValidChannel(_scene->mAnimations[i]->mChannels[j]))
+				++_nbInvalidChannels;
+		}
+	}
+	if (_nbInvalidChannels > 0) {
+		std::cerr << _nbInvalidChannels << " invalid animation channels (no keys or unsorted keys)" \
+			<< " -> replaced by the bind pose" << std::endl;
+	}
+	_nodeChannels.resize(_scene->mNumAnimations);
+	for (u_int32_t i = 0; i < _scene->mNumAnimations; ++i)
+		loadNodeChannels(_scene->mAnimations[i], _nodeChannels[i]);
+	if (_scene->mNumAnimations > 0) {
+		if (ANIMATION_COMPRESSION)
+			compressAnimations();
+		else if (ANIMATION_BAKE_RATE > 0)
+			bakeAnimations();
+		else
+			loadKeyframeAnimations();
+		if (ANIMATION_STATIC_CACHE)
+			loadStaticPoses();
+	}
+
+	calcModelScale();
+	setBonesPos();
+}
+
+
+// flatten the nodes tree in pre-order: a parent is always before its children
+void	ModelAsset::loadSkeleton(const aiNode *node, int parent) {
+	SkeletonNode	skNode;
+	int				id = _skeleton.size();
+
+	skNode.node = node;
+	skNode.parent = parent;
+	auto bone = _boneMap.find(node->mName.data);
+	skNode.boneIndex = (bone != _boneMap.end()) ? bone->second : -1;
+	skNode.localTransform = mat::Affine(aiToMat4(node->mTransformation));
+	aiVector3D		scaling;
+	aiQuaternion	rotation;
+	aiVector3D		translation;
+	node->mTransformation.Decompose(scaling, rotation, translation);
+	skNode.bindTranslation = aiToVec3(translation);
+	skNode.bindRotation = aiToQuat(rotation);
+	skNode.bindScaling = aiToVec3(scaling);
+	skNode.isLeaf = (node->mNumChildren == 0);
+	_skeleton.push_back(skNode);
+
+	for (u_int32_t i = 0; i < node->mNumChildren; ++i) {
+		loadSkeleton(node->mChildren[i], id);
+	}
+}
+
+// nodes sorted by depth (counting sort, the pre-order is kept in each level)
+void	ModelAsset::sortSkeletonLevels() {
+	std::vector<u_int32_t>	depths(_skeleton.size());
+
+	_levelStarts.assign(1, 0);
+	for (u_int32_t i = 0; i < _skeleton.size(); ++i) {
+		depths[i] = (_skeleton[i].parent < 0) ? 0 : depths[_skeleton[i].parent] + 1;
+		if (depths[i] + 2 > _levelStarts.size())
+			_levelStarts.resize(depths[i] + 2, 0);
+		++_levelStarts[depths[i] + 1];
+	}
+	for (u_int32_t level = 1; level < _levelStarts.size(); ++level)
+		_levelStarts[level] += _levelStarts[level - 1];
+
+	std::vector<u_int32_t>	next(_levelStarts.begin(), _levelStarts.end() - 1);
+	_levelNodes.resize(_skeleton.size());
+	for (u_int32_t i = 0; i < _skeleton.size(); ++i)
+		_levelNodes[next[depths[i]]++] = i;
+}
+
+// find the channel of each node once -> no string comparison per frame
+// the invalid channels are removed here so the evaluation never fails
+void	ModelAsset::loadNodeChannels(const aiAnimation *animation, std::vector<const aiNodeAnim*> &channels) const {
+	channels.resize(_skeleton.size());
+	for (u_int32_t i = 0; i < _skeleton.size(); ++i) {
+		const aiNodeAnim *nodeAnim = findNodeAnim(animation, _skeleton[i].node->mName.data);
+		channels[i] = (nodeAnim && isValidChannel(nodeAnim)) ? nodeAnim : nullptr;
+	}
+}
+
+// resample all the animations at ANIMATION_BAKE_RATE
+void	ModelAsset::bakeAnimations() {
+	std::vector<const aiNodeAnim*>	channels;
+
+	_bakedAnimations.clear();
+	for (u_int32_t i = 0; i < _scene->mNumAnimations; ++i) {
+		loadNodeChannels(_scene->mAnimations[i], channels);
+		_bakedAnimations.push_back(BakedAnimation(_scene->mAnimations[i], channels, ANIMATION_BAKE_RATE));
+
+		const BakedAnimation	&baked = _bakedAnimations.back();
+		ClipError				error = baked.getMaxError();
+		size_t					keysSize = 0;
+		for (auto &&nodeAnim : channels) {
+			if (nodeAnim)
+				keysSize += getKeysMemorySize(nodeAnim);
+		}
+		std::cout << "animation " << i << " baked at " << ANIMATION_BAKE_RATE << "Hz: " << baked.getNbFrames() \
+			<< " frames, " << baked.getMemorySize() / 1024 << "KB (keys: " << keysSize / 1024 << "KB)" \
+			<< ", max error: translation " << error.translation << ", rotation " << error.rotation \
+			<< "rad, scaling " << error.scaling << std::endl;
+	}
+}
+
+// copy the keys of all the animations in our layout (see KeyframeAnimation)
+void	ModelAsset::loadKeyframeAnimations() {
+	_keyframeAnimations.clear();
+	for (u_int32_t i = 0; i < _scene->mNumAnimations; ++i) {
+		_keyframeAnimations.push_back(KeyframeAnimation(_scene->mAnimations[i], _nodeChannels[i]));
+
+		size_t	keysSize = 0;
+		for (auto &&nodeAnim : _nodeChannels[i]) {
+			if (nodeAnim)
+				keysSize += getKeysMemorySize(nodeAnim);
+		}
+		std::cout << "animation " << i << " keys: " << _keyframeAnimations.back().getMemorySize() / 1024 \
+			<< "KB (assimp keys: " << keysSize / 1024 << "KB)" << std::endl;
+	}
+}
+
+/*
+find the nodes that do not move in each animation and compute their transforms once
+the pose at time 0 is evaluated with the clip used at runtime: the keys of these nodes are equal,
+the transforms are the same at any time (to the rounding of the interpolation)
+*/
+void	ModelAsset::loadStaticPoses() {
+	std::vector<StaticPose>	staticPoses(_scene->mNumAnimations);  // set at the end: evaluatePose without cache
+
+	for (u_int32_t i = 0; i < _scene->mNumAnimations; ++i) {
+		StaticPose		&staticPose = staticPoses[i];
+		PoseWorkspace	workspace;
+		BonePalette		palette;
+		u_int32_t		nbConstantTracks = 0;
+		u_int32_t		nbStaticNodes = 0;
+
+		evaluatePose(*this, i, 0, workspace, palette);
+		staticPose.isConstant.resize(_skeleton.size());
+		staticPose.isStatic.resize(_skeleton.size());
+		staticPose.locals.resize(_skeleton.size());
+		staticPose.globals.resize(_skeleton.size());
+		for (u_int32_t node = 0; node < _skeleton.size(); ++node) {
+			const aiNodeAnim	*nodeAnim = _nodeChannels[i][node];
+			int					parent = _skeleton[node].parent;
+
+			staticPose.isConstant[node] = !nodeAnim || isConstantChannel(nodeAnim);
+			staticPose.isStatic[node] = staticPose.isConstant[node] && (parent < 0 || staticPose.isStatic[parent]);
+			nbConstantTracks += nodeAnim && staticPose.isConstant[node];
+			nbStaticNodes += staticPose.isStatic[node];
+			staticPose.locals[node] = nodeAnim ? workspace.localTransforms[node] : _skeleton[node].localTransform;
+			staticPose.globals[node] = workspace.nodeTransforms[node];
+			if (staticPose.isStatic[node] && _skeleton[node].boneIndex >= 0) {
+				staticPose.bones.push_back(_skeleton[node].boneIndex);
+				staticPose.palette.push_back(palette[_skeleton[node].boneIndex]);
+			}
+		}
+		std::cout << "animation " << i << " static nodes: " << nbStaticNodes << "/" << _skeleton.size() \
+			<< " (bones: " << staticPose.bones.size() << "), constant tracks: " << nbConstantTracks << std::endl;
+	}
+	_staticPoses = std::move(staticPoses);
+}
+
+// compress all the animations with ANIMATION_COMPRESSION_TOLERANCE (the scene keys are kept by the importer)
+void	ModelAsset::compressAnimations() {
+	std::vector<const aiNodeAnim*>	channels;
+	mat::Vec3						size = _maxPos - _minPos;
+	ClipError						tolerance;
+
+	tolerance.translation = ANIMATION_COMPRESSION_TOLERANCE * std::max(size.x, std::max(size.y, size.z));
+	tolerance.rotation = ANIMATION_COMPRESSION_TOLERANCE;
+	tolerance.scaling = ANIMATION_COMPRESSION_TOLERANCE;
+	_compressedAnimations.clear();
+	for (u_int32_t i = 0; i < _scene->mNumAnimations; ++i) {
+		loadNodeChannels(_scene->mAnimations[i], channels);
+		_compressedAnimations.push_back(CompressedAnimation(_scene->mAnimations[i], channels, tolerance));
+
+		const CompressedAnimation	&compressed = _compressedAnimations.back();
+		ClipError					error = compressed.getMaxError();
+		std::cout << "animation " << i << " compressed: " << compressed.getMemorySize() / 1024 << "KB (ratio " \
+			<< compressed.getCompressionRatio() << ")" \
+			<< ", max error: translation " << error.translation << ", rotation " << error.rotation \
+			<< "rad, scaling " << error.scaling << std::endl;
+	}
+}
+
+// bind pose position of each bone
+void	ModelAsset::setBonesPos() {
+	std::vector<mat::Affine>	nodeGlobalTransforms(_skeleton.size());
+
+	for (u_int32_t i = 0; i < _skeleton.size(); ++i) {
+		const SkeletonNode	&skNode = _skeleton[i];
+		const mat::Affine	&parentTransform = (skNode.parent < 0) ? _globalTransform \
+			: nodeGlobalTransforms[skNode.parent];
+
+		nodeGlobalTransforms[i] = parentTransform * skNode.localTransform;
+		if (skNode.boneIndex >= 0) {
+			const float *global = nodeGlobalTransforms[i].getData();
+			for (u_int32_t j = 0; j < 3; ++j)
+				_bonePosUniform[skNode.boneIndex * 3 + j] = global[3 + 4 * j];
+		}
+	}
+}
+
+
+// the 3 keys arrays are not empty and sorted by time
+bool	ModelAsset::isValidChannel(const aiNodeAnim *nodeAnim) {
+	return isValidKeys(nodeAnim->mPositionKeys, nodeAnim->mNumPositionKeys) \
+		&& isValidKeys(nodeAnim->mRotationKeys, nodeAnim->mNumRotationKeys) \
+		&& isValidKeys(nodeAnim->mScalingKeys, nodeAnim->mNumScalingKeys);
+}
+
+const aiNodeAnim*	ModelAsset::findNodeAnim(const aiAnimation* animation, const std::string nodeName) const
+{
+    for (uint i = 0 ; i < animation->mNumChannels ; i++) {
+        const aiNodeAnim* nodeAnim = animation->mChannels[i];
+
+        if (std::string(nodeAnim->mNodeName.data) == nodeName) {
+            return nodeAnim;
+        }
+    }
+
+    return NULL;
+}
+
+void	ModelAsset::processNode(aiNode *node, const aiScene *scene) {
+	aiMesh	*mesh;
+
+	// process all the node's _meshes (if any)
+	for (u_int32_t i = 0; i < node->mNumMeshes; ++i) {
+		mesh = scene->mMeshes[node->mMeshes[i]];
+		_meshes.push_back(processMesh(mesh, scene));
+	}
+	// recursion with each of its children
+	for (u_int32_t i = 0; i < node->mNumChildren; ++i)
+		processNode(node->mChildren[i], scene);
+}
+
+Material	loadMaterial(aiMaterial *mat) {
+	Material material;
+	aiColor3D color(0.f, 0.f, 0.f);
+	float shininess;
+
+	if (mat->Get(AI_MATKEY_COLOR_DIFFUSE, color) == AI_SUCCESS) {
+		material.diffuse = mat::Vec3(color.r, color.g, color.b);
+	}
+	else {
+		#if DEBUG
+			std::cout << "Error when loading DIFFUSE" << std::endl;
+		#endif
+	}
+
+	if (mat->Get(AI_MATKEY_COLOR_AMBIENT, color) == AI_SUCCESS) {
+		material.ambient = mat::Vec3(color.r, color.g, color.b);
+	}
+	else {
+		#if DEBUG
+			std::cout << "Error when loading AMBIENT" << std::endl;
+		#endif
+	}
+
+	if (mat->Get(AI_MATKEY_COLOR_SPECULAR, color) == AI_SUCCESS) {
+		material.specular = mat::Vec3(color.r, color.g, color.b);
+	}
+	else {
+		#if DEBUG
+			std::cout << "Error when loading SPECULAR" << std::endl;
+		#endif
+	}
+
+	if (mat->Get(AI_MATKEY_SHININESS, shininess) == AI_SUCCESS) {
+		material.shininess = shininess;
+	}
+	else {
+		#if DEBUG
+			std::cout << "Error when loading SHININESS" << std::endl;
+		#endif
+	}
+
+	return material;
+}
+
+// update min/max pos to use later to scale and center the model
+void	ModelAsset::updateMinMaxPos(const mat::Vec3Array &positions) {
+	mat::Vec3	min;
+	mat::Vec3	max;
+
+	mat::bounds(positions, min, max);
+	for (int axis = 0; axis < 3; ++axis) {
+		if (max[axis] > _maxPos[axis])
+			_maxPos[axis] = max[axis];
+		if (min[axis] < _minPos[axis])
+			_minPos[axis] = min[axis];
+	}
+}
+
+// calculate the matrix to scale and center the model
+void	ModelAsset::calcModelScale() {
+	mat::Vec3	transl;
+	float		maxDiff;
+	float		scale;
+
+	// calculate scale
+	maxDiff = _maxPos.x - _minPos.x;
+	if (maxDiff < _maxPos.y - _minPos.y)
+		maxDiff = _maxPos.y - _minPos.y;
+	if (maxDiff < _maxPos.z - _minPos.z)
+		maxDiff = _maxPos.z - _minPos.z;
+	maxDiff /= 2;
+	scale = 1.0f / maxDiff;
+	_modelScale = mat::Mat4(1.0f);
+
+	// apply the scale
+	_modelScale = _modelScale.scale(mat::Vec3(scale, scale, scale));
+
+	// calculate the translation
+	transl.x = -((_minPos.x + _maxPos.x) / 2);
+	transl.y = -((_minPos.y + _maxPos.y) / 2);
+	transl.z = -((_minPos.z + _maxPos.z) / 2);
+	// verification due to float precision
+	transl.x = scale * ((transl.x < 0.00001f && transl.x > -0.00001f) ? 0.0f : transl.x);
+	transl.y = scale * ((transl.y < 0.00001f && transl.y > -0.00001f) ? 0.0f : transl.y);
+	transl.z = scale * ((transl.z < 0.00001f && transl.z > -0.00001f) ? 0.0f : transl.z);
+	// apply the translation
+	_modelScale = _modelScale.translate(transl);
+}
+
+
+Mesh	ModelAsset::processMesh(aiMesh *mesh, const aiScene *scene) {
+	std::vector<VertexMat>	vertices;
+	VertexMat				vertex;
+
+	std::vector<u_int32_t>	indices;
+	aiFace					face;
+
+	std::vector<Texture>	textures;
+	aiMaterial				*material;
+	std::vector<Texture>	diffuseMaps;
+	std::vector<Texture>	specularMaps;
+	std::vector<Texture>	normalMaps;
+
+	u_int32_t				boneIndex;
+	std::string				boneName;
+	int						vertexID;
+	float					weight;
+
+	// update the min/max pos (all the vertices at once)
+	mat::Vec3Array	positions;
+	positions.load(&mesh->mVertices[0].x, mesh->mNumVertices, sizeof(aiVector3D) / sizeof(float));
+	updateMinMaxPos(positions);
+
+    // process vertices
+	for (u_int32_t i = 0; i < mesh->mNumVertices; ++i) {
+		// process vertex positions
+		vertex.pos.x = mesh->mVertices[i].x;
+		vertex.pos.y = mesh->mVertices[i].y;
+		vertex.pos.z = mesh->mVertices[i].z;
+		// process vertex normals
+		vertex.norm.x = mesh->mNormals[i].x;
+		vertex.norm.y = mesh->mNormals[i].y;
+		vertex.norm.z = mesh->mNormals[i].z;
+		// process vertex texture coordinates
+		vertex.texCoords = mat::Vec2(0.0f, 0.0f);
+		if (mesh->mTextureCoords[0]) {
+			vertex.texCoords.x = mesh->mTextureCoords[0][i].x;
+			vertex.texCoords.y = mesh->mTextureCoords[0][i].y;
+		}
+		// process vertex tangents (for normal map)
+		vertex.tangents.x = mesh->mTangents[i].x;
+		vertex.tangents.y = mesh->mTangents[i].y;
+		vertex.tangents.z = mesh->mTangents[i].z;
+
+		vertices.push_back(vertex);
+	}
+
+    // process indices
+	for (u_int32_t i = 0; i < mesh->mNumFaces; ++i) {
+		face = mesh->mFaces[i];
+		// all face is conposed of 3 indices due to aiProcess_Triangulate
+		for (u_int32_t j = 0; j < face.mNumIndices; ++j)
+			indices.push_back(face.mIndices[j]);
+	}
+
+	// process material
+	material = scene->mMaterials[mesh->mMaterialIndex];
+	bool failedToLoadTex = false;
+	try {
+		// load diffuse textures
+		diffuseMaps = loadMaterialTextures(scene, material, aiTextureType_DIFFUSE, \
+		TextureT::difuse);
+		textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+	}
+	catch (TextureFailToLoad &e) {
+		failedToLoadTex = true;
+	}
+	try {
+		// load specular textures
+		specularMaps = loadMaterialTextures(scene, material, aiTextureType_SPECULAR, \
+		TextureT::specular);
+		textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+	}
+	catch (TextureFailToLoad &e) {
+		failedToLoadTex = true;
+	}
+	try {
+		// load specular textures
+		normalMaps = loadMaterialTextures(scene, material, aiTextureType_NORMALS, \
+		TextureT::normal);
+		textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
+	}
+	catch (TextureFailToLoad &e) {
+		failedToLoadTex = true;
+	}
+
+	// create the mesh
+	Mesh ret = Mesh(vertices, indices, textures, loadMaterial(material));
+	if (failedToLoadTex) {
+		ret = Mesh(vertices, indices, textures, Material());
+	}
+
+	// process bones
+	for (u_int32_t i = 0; i < mesh->mNumBones; ++i) {
+        boneIndex = 0;
+        boneName = mesh->mBones[i]->mName.data;
+
+		// if the bone don't exist yet
+        if (_boneMap.find(boneName) == _boneMap.end()) {
+            boneIndex = _actBoneId;
+            ++_actBoneId;
+            _boneOffsets[_actBoneId] = mat::Affine();
+        }
+        else {
+            boneIndex = _boneMap[boneName];
+        }
+
+        _boneMap[boneName] = boneIndex;
+        _boneOffsets[boneIndex] = mat::Affine(aiToMat4(mesh->mBones[i]->mOffsetMatrix));
+
+		// add boneId ad weight to the mesh
+		for (u_int32_t j = 0; j < mesh->mBones[i]->mNumWeights; ++j) {
+			vertexID = mesh->mBones[i]->mWeights[j].mVertexId;
+			weight = mesh->mBones[i]->mWeights[j].mWeight;
+			if (weight <= 0.1)
+				continue;
+			ret.addBoneData(boneIndex, weight, vertexID);
+		}
+	}
+
+	if (_withGpu)
+		ret.setupMesh();
+	return ret;
+}
+
+std::vector<Texture>	ModelAsset::loadMaterialTextures(const aiScene *scene, aiMaterial *mat, \
+aiTextureType type, TextureT textType) {
+    std::vector<Texture>	textures;
+	aiString				textLocation;
+	std::string				location;
+	Texture					texture;
+	bool					skip;
+	int						loactionId;
+
+	if (!_withGpu)
+		return textures;
+	mat->Get(AI_MATKEY_TEXTURE(type, 0), textLocation);
+	location = textLocation.C_Str();
+
+	skip = false;
+	// verify if the texture has been loaded already
+	for (u_int32_t j = 0; j < _texturesLoaded.size(); ++j) {
+		if (location == _texturesLoaded[j].path) {
+			textures.push_back(_texturesLoaded[j]);
+			skip = true;
+			break;
+		}
+	}
+
+	if (!skip && location.length() != 0) {
+		bool inSpaceSRGB = textType == TextureT::difuse || textType == TextureT::specular;
+		// embedded texture type
+		if (location[0] == '*') {
+			loactionId = std::stoi(location.substr(1));
+			texture.id = textureFromFbx(scene, loactionId, inSpaceSRGB);
+		}
+		// regular file texture type
+		else {
+			texture.id = textureFromFile(location, _directory, inSpaceSRGB);
+		}
+		texture.type = textType;
+		texture.path = location;
+		textures.push_back(texture);
+		// save to _texturesLoaded array to skip duplicate textures loading later
+		_texturesLoaded.push_back(texture);
+	}
+
+    return textures;
+}
+
+// send cube data to draw a cube at the bones origin later
+void	ModelAsset::sendCubeData() {
+    glGenVertexArrays(1, &_cubeVao);
+    glGenBuffers(1, &_cubeVbo);
+
+    glBindBuffer(GL_ARRAY_BUFFER, _cubeVbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(ModelAsset::_cubeData), ModelAsset::_cubeData.getData(), GL_STATIC_DRAW);
+
+    glBindVertexArray(_cubeVao);
+    glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(5);
+    glVertexAttribPointer(6, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(6);
+    glVertexAttribPointer(7, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    glEnableVertexAttribArray(7);
+}
+
+const char* ModelAsset::AssimpError::what() const throw() {
+    return ("Assimp failed to load the model!");
+}
+
+std::string const					&ModelAsset::getPath() const { return _path; }
+bool								ModelAsset::hasGpu() const { return _withGpu; }
+std::vector<Mesh> const				&ModelAsset::getMeshes() const { return _meshes; }
+std::string const					&ModelAsset::getDirectory() const { return _directory; }
+std::vector<Texture> const			&ModelAsset::getTexturesLoaded() const { return _texturesLoaded; }
+mat::Vec3							ModelAsset::getMinPos() const { return _minPos; }
+mat::Vec3							ModelAsset::getMaxPos() const { return _maxPos; }
+mat::Mat4 const						&ModelAsset::getModelScale() const { return _modelScale; }
+std::map<std::string, int> const	&ModelAsset::getBoneMap() const { return _boneMap; }
+mat::Affine const					&ModelAsset::getBoneOffset(u_int32_t boneIndex) const { return _boneOffsets[boneIndex]; }
+std::array<float, MAX_BONES * 3> const	&ModelAsset::getBonePosUniform() const { return _bonePosUniform; }
+u_int32_t							ModelAsset::getActBoneId() const { return _actBoneId; }
+u_int32_t							ModelAsset::getNbInvalidChannels() const { return _nbInvalidChannels; }
+mat::Affine const					&ModelAsset::getGlobalTransform() const { return _globalTransform; }
+mat::Affine const					&ModelAsset::getGlobalInverseTransform() const { return _globalInverseTransform; }
+std::vector<ModelAsset::SkeletonNode> const	&ModelAsset::getSkeleton() const { return _skeleton; }
+std::vector<u_int32_t> const		&ModelAsset::getLevelNodes() const { return _levelNodes; }
+std::vector<u_int32_t> const		&ModelAsset::getLevelStarts() const { return _levelStarts; }
+bool								ModelAsset::isAnimated() const { return _scene->mNumAnimations > 0; }
+u_int32_t							ModelAsset::getNbAnimations() const { return _scene->mNumAnimations; }
+const aiAnimation					*ModelAsset::getAnimation(u_int32_t animationId) const {
+	return _scene->mAnimations[animationId];
+}
+std::vector<const aiNodeAnim*> const	&ModelAsset::getNodeChannels(u_int32_t animationId) const {
+	return _nodeChannels[animationId];
+}
+const BakedAnimation				*ModelAsset::getBakedAnimation(u_int32_t animationId) const {
+	return _bakedAnimations.empty() ? nullptr : &_bakedAnimations[animationId];
+}
+const CompressedAnimation			*ModelAsset::getCompressedAnimation(u_int32_t animationId) const {
+	return _compressedAnimations.empty() ? nullptr : &_compressedAnimations[animationId];
+}
+const KeyframeAnimation				*ModelAsset::getKeyframeAnimation(u_int32_t animationId) const {
+	return _keyframeAnimations.empty() ? nullptr : &_keyframeAnimations[animationId];
+}
+const ModelAsset::StaticPose		*ModelAsset::getStaticPose(u_int32_t animationId) const {
+	return _staticPoses.empty() ? nullptr : &_staticPoses[animationId];
+}
+u_int32_t							ModelAsset::getCubeVbo() const { return _cubeVbo; }
+u_int32_t							ModelAsset::getCubeVao() const { return _cubeVao; }
@@ -0,0 +1,410 @@
+#include "Pose.hpp"
+#include <algorithm>
+
+namespace {
+	// tracks of an animation, staticPose: the constant tracks are not sampled (nullptr to sample all the tracks)
+	void	resetTracks(ModelAsset const &asset, u_int32_t animationId, const ModelAsset::StaticPose *staticPose, \
+	PoseWorkspace &workspace) {
+		const std::vector<ModelAsset::SkeletonNode>	&skeleton = asset.getSkeleton();
+		const std::vector<const aiNodeAnim*>		&nodeChannels = asset.getNodeChannels(animationId);
+
+		workspace.asset = &asset;
+		workspace.animationId = animationId;
+		workspace.cursors.assign(skeleton.size(), ChannelCursor());
+
+		// tracks: same order as the tracks of the clips
+		workspace.trackNodes.clear();
+		workspace.nodeTracks.assign(skeleton.size(), -1);
+		workspace.trackRuns.clear();
+		workspace.nbRunTracks = 0;
+		workspace.nbRunLeafTracks = 0;
+		for (u_int32_t i = 0; i < skeleton.size(); ++i) {
+			if (!nodeChannels[i])
+				continue;
+			u_int32_t track = workspace.trackNodes.size();
+			workspace.nodeTracks[i] = track;
+			workspace.trackNodes.push_back(i);
+			if (staticPose && staticPose->isConstant[i])
+				continue;
+			if (workspace.trackRuns.empty() || workspace.trackRuns.back().second != track)
+				workspace.trackRuns.push_back(std::make_pair(track, track));
+			++workspace.trackRuns.back().second;
+			++workspace.nbRunTracks;
+			workspace.nbRunLeafTracks += skeleton[i].isLeaf;
+		}
+		workspace.trackPose.resize(workspace.trackNodes.size());
+		workspace.trackKeys.resize(workspace.trackNodes.size());
+	}
+
+	// tables of the local, global and bone transforms of the tracks of the workspace (see composePose)
+	void	resetHierarchy(ModelAsset const &asset, const ModelAsset::StaticPose *staticPose, PoseWorkspace &workspace) {
+		const std::vector<ModelAsset::SkeletonNode>	&skeleton = asset.getSkeleton();
+		const std::vector<u_int32_t>				&levelNodes = asset.getLevelNodes();
+		const std::vector<u_int32_t>				&levelStarts = asset.getLevelStarts();
+		auto isStatic = [staticPose](u_int32_t node) { return staticPose && staticPose->isStatic[node]; };
+
+		workspace.nodeTransforms.resize(skeleton.size());
+		workspace.globalTransform = asset.getGlobalTransform();
+		workspace.globalInverseTransform = asset.getGlobalInverseTransform();
+		workspace.localTransforms.resize(skeleton.size());
+		workspace.trackLocals.resize(workspace.trackNodes.size());
+		for (u_int32_t t = 0; t < workspace.trackNodes.size(); ++t)
+			workspace.trackLocals[t] = &workspace.localTransforms[workspace.trackNodes[t]];
+
+		// levels without the static nodes: levelLocals depends on skipLeaves, it is set by composePose
+		workspace.levelNodes.clear();
+		workspace.levelStarts.assign(1, 0);
+		for (u_int32_t level = 0; level + 1 < levelStarts.size(); ++level) {
+			for (u_int32_t j = levelStarts[level]; j < levelStarts[level + 1]; ++j) {
+				if (!isStatic(levelNodes[j]))
+					workspace.levelNodes.push_back(levelNodes[j]);
+			}
+			if (workspace.levelNodes.size() > workspace.levelStarts.back())
+				workspace.levelStarts.push_back(workspace.levelNodes.size());
+		}
+		workspace.levelParents.resize(workspace.levelNodes.size());
+		workspace.levelLocals.resize(workspace.levelNodes.size());
+		workspace.levelGlobals.resize(workspace.levelNodes.size());
+		workspace.levelSkipLeaves = -1;
+		for (u_int32_t j = 0; j < workspace.levelNodes.size(); ++j) {
+			int parent = skeleton[workspace.levelNodes[j]].parent;
+			if (parent < 0)
+				workspace.levelParents[j] = &workspace.globalTransform;
+			else if (isStatic(parent))
+				workspace.levelParents[j] = &staticPose->globals[parent];
+			else
+				workspace.levelParents[j] = &workspace.nodeTransforms[parent];
+			workspace.levelGlobals[j] = &workspace.nodeTransforms[workspace.levelNodes[j]];
+		}
+
+		// bones
+		workspace.boneInverses.clear();
+		workspace.boneGlobals.clear();
+		workspace.boneOffsets.clear();
+		workspace.boneIndexes.clear();
+		for (u_int32_t i = 0; i < skeleton.size(); ++i) {
+			if (skeleton[i].boneIndex >= 0 && !isStatic(i)) {
+				workspace.boneInverses.push_back(&workspace.globalInverseTransform);
+				workspace.boneGlobals.push_back(&workspace.nodeTransforms[i]);
+				workspace.boneOffsets.push_back(&asset.getBoneOffset(skeleton[i].boneIndex));
+				workspace.boneIndexes.push_back(skeleton[i].boneIndex);
+			}
+		}
+		workspace.boneTransforms.resize(workspace.boneIndexes.size());
+		workspace.boneTmp.resize(workspace.boneIndexes.size());
+		workspace.boneOut.resize(workspace.boneIndexes.size());
+		for (u_int32_t k = 0; k < workspace.boneIndexes.size(); ++k)
+			workspace.boneTmp[k] = &workspace.boneTransforms[k];
+	}
+
+	// tables of the workspace for an animation of an asset
+	void	resetWorkspace(ModelAsset const &asset, u_int32_t animationId, PoseWorkspace &workspace) {
+		const ModelAsset::StaticPose	*staticPose = asset.getStaticPose(animationId);
+
+		resetTracks(asset, animationId, staticPose, workspace);
+		resetHierarchy(asset, staticPose, workspace);
+	}
+
+	// local transform of the tracks of the runs in workspace.trackPose, return the number of tracks sampled
+	u_int32_t	sampleTracks(ModelAsset const &asset, u_int32_t animationId, float time, PoseWorkspace &workspace, \
+	bool skipLeaves) {
+		const std::vector<ModelAsset::SkeletonNode>	&skeleton = asset.getSkeleton();
+		const std::vector<const aiNodeAnim*>		&nodeChannels = asset.getNodeChannels(animationId);
+		const BakedAnimation						*baked = asset.getBakedAnimation(animationId);
+		const CompressedAnimation					*compressed = asset.getCompressedAnimation(animationId);
+		const KeyframeAnimation						*keyframes = asset.getKeyframeAnimation(animationId);
+		const std::vector<u_int32_t>				&trackNodes = workspace.trackNodes;
+		TrackPose									&pose = workspace.trackPose;
+
+		if (!compressed && baked) {
+			baked->sampleTracks(time, pose);  // all the tracks: one lerp per component
+		}
+		else if (!compressed && keyframes) {
+			for (auto &&run : workspace.trackRuns) {
+				for (u_int32_t t = run.first; t < run.second; ++t) {
+					if (!(skipLeaves && skeleton[trackNodes[t]].isLeaf))
+						keyframes->findKeys(time, t, workspace.cursors[trackNodes[t]], workspace.trackKeys);
+				}
+			}
+			workspace.trackKeys.interpolate(pose);
+		}
+		else {
+			for (auto &&run : workspace.trackRuns) {
+				for (u_int32_t t = run.first; t < run.second; ++t) {
+					u_int32_t	node = trackNodes[t];
+					if (skipLeaves && skeleton[node].isLeaf)
+						continue;
+					mat::Vec3 scaling;
+					mat::Quaternion rotationQ;
+					mat::Vec3 translation;
+					if (compressed)
+						compressed->sample(time, t, workspace.cursors[node], translation, rotationQ, scaling);
+					else
+						sampleChannel(nodeChannels[node], time, workspace.cursors[node], translation, rotationQ, \
+							scaling);
+					pose.set(t, translation, rotationQ, scaling);
+				}
+			}
+		}
+		return workspace.nbRunTracks - (skipLeaves ? workspace.nbRunLeafTracks : 0);
+	}
+
+	// local, global and bone transforms from workspace.trackPose (the tracks of the runs)
+	void	composePose(ModelAsset const &asset, const ModelAsset::StaticPose *staticPose, PoseWorkspace &workspace, \
+	BonePalette &palette, bool skipLeaves) {
+		const std::vector<ModelAsset::SkeletonNode>	&skeleton = asset.getSkeleton();
+		TrackPose									&pose = workspace.trackPose;
+
+		// the skipped leaves of a run are converted too (not used, it keeps the batches full)
+		mat::QuaternionSoA	rotations = pose.getRotations();
+		for (auto &&run : workspace.trackRuns) {
+			u_int32_t	first = run.first;
+			const float	*translations[3] = {pose.get(TrackPose::TX) + first, pose.get(TrackPose::TY) + first, \
+				pose.get(TrackPose::TZ) + first};
+			const float	*scalings[3] = {pose.get(TrackPose::SX) + first, pose.get(TrackPose::SY) + first, \
+				pose.get(TrackPose::SZ) + first};
+			mat::QuaternionSoA	runRotations = {rotations.x + first, rotations.y + first, rotations.z + first, \
+				rotations.w + first};
+			mat::composeBatch(translations, runRotations, scalings, workspace.trackLocals.data() + first, \
+				run.second - first);
+		}
+
+		// global transforms, level by level
+		if (workspace.levelSkipLeaves != skipLeaves) {
+			for (u_int32_t j = 0; j < workspace.levelNodes.size(); ++j) {
+				u_int32_t						node = workspace.levelNodes[j];
+				const ModelAsset::SkeletonNode	&skNode = skeleton[node];
+				if (workspace.nodeTracks[node] < 0 || (skipLeaves && skNode.isLeaf))
+					workspace.levelLocals[j] = &skNode.localTransform;
+				else if (staticPose && staticPose->isConstant[node])
+					workspace.levelLocals[j] = &staticPose->locals[node];
+				else
+					workspace.levelLocals[j] = &workspace.localTransforms[node];
+			}
+			workspace.levelSkipLeaves = skipLeaves;
+		}
+		for (u_int32_t level = 0; level + 1 < workspace.levelStarts.size(); ++level) {
+			u_int32_t start = workspace.levelStarts[level];
+			mat::mulBatch(workspace.levelParents.data() + start, workspace.levelLocals.data() + start, \
+				workspace.levelGlobals.data() + start, workspace.levelStarts[level + 1] - start);
+		}
+
+		// palette
+		for (u_int32_t k = 0; k < workspace.boneIndexes.size(); ++k)
+			workspace.boneOut[k] = &palette[workspace.boneIndexes[k]];
+		mat::mulBatch(workspace.boneInverses.data(), workspace.boneGlobals.data(), workspace.boneTmp.data(), \
+			workspace.boneIndexes.size());
+		mat::mulBatch(workspace.boneTmp.data(), workspace.boneOffsets.data(), workspace.boneOut.data(), \
+			workspace.boneIndexes.size());
+		workspace.nbCachedBones = 0;
+		if (staticPose) {
+			for (u_int32_t k = 0; k < staticPose->bones.size(); ++k)
+				palette[staticPose->bones[k]] = staticPose->palette[k];
+			workspace.nbCachedBones = staticPose->bones.size();
+		}
+	}
+
+	// the track t of from is the track tracks[t] of to
+	void	scatterTracks(TrackPose const &from, std::vector<u_int32_t> const &tracks, TrackPose &to) {
+		for (int c = 0; c < TrackPose::NB_COMPONENTS; ++c) {
+			const float	*src = from.get(c);
+			float		*dst = to.get(c);
+			for (u_int32_t t = 0; t < tracks.size(); ++t)
+				dst[tracks[t]] = src[t];
+		}
+	}
+
+	// tables of the blend workspace for the layers: the clip of each layer is sampled on all its tracks
+	void	resetBlend(ModelAsset const &asset, const PoseLayer *layers, u_int32_t nbLayers, BlendWorkspace &workspace) {
+		const std::vector<ModelAsset::SkeletonNode>	&skeleton = asset.getSkeleton();
+		PoseWorkspace								&blended = workspace.blended;
+
+		workspace.asset = &asset;
+		workspace.animationIds.resize(nbLayers);
+		workspace.additives.resize(nbLayers);
+		for (u_int32_t i = 0; i < nbLayers; ++i) {
+			workspace.animationIds[i] = layers[i].animationId;
+			workspace.additives[i] = layers[i].additive;
+		}
+
+		// tracks of the blended pose: the nodes animated by at least one layer, in one run
+		blended.asset = &asset;
+		blended.cursors.clear();
+		blended.trackNodes.clear();
+		blended.nodeTracks.assign(skeleton.size(), -1);
+		blended.nbRunLeafTracks = 0;
+		for (u_int32_t node = 0; node < skeleton.size(); ++node) {
+			for (u_int32_t i = 0; i < nbLayers; ++i) {
+				if (asset.getNodeChannels(layers[i].animationId)[node]) {
+					blended.nodeTracks[node] = blended.trackNodes.size();
+					blended.trackNodes.push_back(node);
+					blended.nbRunLeafTracks += skeleton[node].isLeaf;
+					break;
+				}
+			}
+		}
+		u_int32_t	nbTracks = blended.trackNodes.size();
+		blended.nbRunTracks = nbTracks;
+		blended.trackRuns.assign(1, std::make_pair(0u, nbTracks));
+		blended.trackPose.resize(nbTracks);
+		resetHierarchy(asset, nullptr, blended);
+
+		// pose of each layer on the tracks of the blended pose: bind pose where its clip is not animated
+		workspace.bindPose.resize(nbTracks);
+		for (u_int32_t t = 0; t < nbTracks; ++t) {
+			const ModelAsset::SkeletonNode	&skNode = skeleton[blended.trackNodes[t]];
+			workspace.bindPose.set(t, skNode.bindTranslation, skNode.bindRotation, skNode.bindScaling);
+		}
+		workspace.layers.resize(nbLayers);
+		workspace.layerTracks.resize(nbLayers);
+		workspace.layerPoses.assign(nbLayers, workspace.bindPose);
+		workspace.referencePoses.resize(nbLayers);
+		for (u_int32_t i = 0; i < nbLayers; ++i) {
+			PoseWorkspace	&layer = workspace.layers[i];
+			resetTracks(asset, layers[i].animationId, nullptr, layer);
+			workspace.layerTracks[i].resize(layer.trackNodes.size());
+			for (u_int32_t t = 0; t < layer.trackNodes.size(); ++t)
+				workspace.layerTracks[i][t] = blended.nodeTracks[layer.trackNodes[t]];
+			if (!layers[i].additive)
+				continue;
+			// additive: difference with the first pose of the clip, its rotation is stored inverted
+			TrackPose	&reference = workspace.referencePoses[i];
+			reference = workspace.bindPose;
+			sampleTracks(asset, layers[i].animationId, 0, layer, false);
+			scatterTracks(layer.trackPose, workspace.layerTracks[i], reference);
+			for (int c = TrackPose::RX; c <= TrackPose::RZ; ++c) {
+				for (u_int32_t t = 0; t < nbTracks; ++t)
+					reference.get(c)[t] = -reference.get(c)[t];
+			}
+		}
+		workspace.identity.resize(nbTracks);
+		for (u_int32_t t = 0; t < nbTracks; ++t)
+			workspace.identity.set(t, mat::Vec3(0, 0, 0), mat::Quaternion(), mat::Vec3(1, 1, 1));
+		workspace.deltas.resize(nbTracks);
+		workspace.weights.resize(nbTracks);
+	}
+}
+
+u_int32_t	evaluatePose(ModelAsset const &asset, u_int32_t animationId, float time, PoseWorkspace &workspace, \
+BonePalette &palette, bool skipLeaves) {
+	if (workspace.asset != &asset || workspace.animationId != animationId)
+		resetWorkspace(asset, animationId, workspace);
+	u_int32_t	nbSampled = sampleTracks(asset, animationId, time, workspace, skipLeaves);
+	composePose(asset, asset.getStaticPose(animationId), workspace, palette, skipLeaves);
+	return nbSampled;
+}
+
+u_int32_t	evaluateBlendedPose(ModelAsset const &asset, const PoseLayer *layers, u_int32_t nbLayers, \
+BlendWorkspace &workspace, BonePalette &palette, bool skipLeaves) {
+	bool	isSame = (workspace.asset == &asset && workspace.animationIds.size() == nbLayers);
+	for (u_int32_t i = 0; isSame && i < nbLayers; ++i)
+		isSame = (workspace.animationIds[i] == layers[i].animationId && workspace.additives[i] == layers[i].additive);
+	if (!isSame)
+		resetBlend(asset, layers, nbLayers, workspace);
+
+	TrackPose	&blended = workspace.blended.trackPose;
+	TrackPose	*below = nullptr;  // pose of the layers below the current one
+	int			nbTracks = blended.getNbTracks();
+	u_int32_t	nbSampled = 0;
+	for (u_int32_t i = 0; i < nbLayers; ++i) {
+		PoseWorkspace	&layer = workspace.layers[i];
+		nbSampled += sampleTracks(asset, layers[i].animationId, layers[i].time, layer, skipLeaves);
+		// the clip animates all the tracks of the blended pose: same tracks, no copy
+		bool			isAllTracks = (workspace.layerTracks[i].size() == static_cast<u_int32_t>(nbTracks));
+		TrackPose		&layerPose = isAllTracks ? layer.trackPose : workspace.layerPoses[i];
+		if (!isAllTracks)
+			scatterTracks(layer.trackPose, workspace.layerTracks[i], layerPose);
+		if (i == 0) {
+			below = &layerPose;
+			continue;
+		}
+
+		float	weight = std::min(std::max(layers[i].weight, 0.0f), 1.0f);
+		std::fill(workspace.weights.begin(), workspace.weights.end(), weight);
+		mat::QuaternionSoA	rotations = blended.getRotations();
+		if (layers[i].additive) {
+			// below + weight * (layer - reference), rotation: below * nlerp(identity, reference^-1 * layer)
+			TrackPose	&reference = workspace.referencePoses[i];
+			for (int c : {TrackPose::TX, TrackPose::TY, TrackPose::TZ, TrackPose::SX, TrackPose::SY, TrackPose::SZ}) {
+				const float	*b = below->get(c);
+				const float	*l = layerPose.get(c);
+				const float	*r = reference.get(c);
+				float		*out = blended.get(c);
+				for (int t = 0; t < nbTracks; ++t)
+					out[t] = b[t] + weight * (l[t] - r[t]);
+			}
+			mat::QuaternionSoA	deltas = workspace.deltas.getRotations();
+			mat::mulBatch(reference.getRotations(), layerPose.getRotations(), deltas, nbTracks);
+			mat::nlerpBatch(workspace.identity.getRotations(), deltas, workspace.weights.data(), deltas, nbTracks);
+			mat::mulBatch(below->getRotations(), deltas, rotations, nbTracks);
+			mat::normalizeBatch(rotations, rotations, nbTracks);
+		}
+		else {
+			for (int c : {TrackPose::TX, TrackPose::TY, TrackPose::TZ, TrackPose::SX, TrackPose::SY, TrackPose::SZ})
+				mat::lerpBatch(below->get(c), layerPose.get(c), weight, blended.get(c), nbTracks);
+			mat::nlerpBatch(below->getRotations(), layerPose.getRotations(), workspace.weights.data(), rotations, \
+				nbTracks);
+		}
+		below = &blended;
+	}
+	if (below != &blended)
+		blended = *below;  // only one layer
+
+	composePose(asset, nullptr, workspace.blended, palette, skipLeaves);
+	return nbSampled;
+}
+
+// the skeleton is in pre-order so the parent global transform is always computed before its children
+u_int32_t	evaluatePoseScalar(ModelAsset const &asset, u_int32_t animationId, float time, \
+PoseWorkspace &workspace, BonePalette &palette, bool skipLeaves) {
+	const std::vector<ModelAsset::SkeletonNode>	&skeleton = asset.getSkeleton();
+	const std::vector<const aiNodeAnim*>		&nodeChannels = asset.getNodeChannels(animationId);
+	const BakedAnimation						*baked = asset.getBakedAnimation(animationId);
+	const CompressedAnimation					*compressed = asset.getCompressedAnimation(animationId);
+	const KeyframeAnimation						*keyframes = asset.getKeyframeAnimation(animationId);
+	const mat::Affine							&globalTransform = asset.getGlobalTransform();
+	const mat::Affine							&globalInverseTransform = asset.getGlobalInverseTransform();
+	u_int32_t									nbSampled = 0;
+
+	if (workspace.asset != &asset || workspace.animationId != animationId)
+		resetWorkspace(asset, animationId, workspace);
+	std::vector<mat::Affine>	&nodeTransforms = workspace.nodeTransforms;
+
+	for (u_int32_t i = 0; i < skeleton.size(); ++i) {
+		const ModelAsset::SkeletonNode	&skNode = skeleton[i];
+		const aiNodeAnim				*nodeAnim = nodeChannels[i];
+		const mat::Affine				&parentTransform = (skNode.parent < 0) ? globalTransform \
+			: nodeTransforms[skNode.parent];
+
+		if (nodeAnim && !(skipLeaves && skNode.isLeaf)) {
+			++nbSampled;
+			// Interpolate scaling, rotation and translation
+			mat::Vec3 scaling;
+			mat::Quaternion rotationQ;
+			mat::Vec3 translation;
+			if (compressed)
+				compressed->sample(time, compressed->getTrack(i), workspace.cursors[i], translation, rotationQ, \
+					scaling);
+			else if (baked)
+				baked->sample(time, baked->getTrack(i), translation, rotationQ, scaling);
+			else if (keyframes)
+				keyframes->sample(time, keyframes->getTrack(i), workspace.cursors[i], translation, rotationQ, \
+					scaling);
+			else
+				sampleChannel(nodeAnim, time, workspace.cursors[i], translation, rotationQ, scaling);
+
+			// Combine the above transformations (translation * rotation * scaling)
+			nodeTransforms[i] = parentTransform * mat::Affine(translation, rotationQ, scaling);
+		}
+		else {
+			nodeTransforms[i] = parentTransform * skNode.localTransform;
+		}
+
+		if (skNode.boneIndex >= 0) {
+			// evaluated in one pass, without intermediate matrix
+			(mat::expr::lazy(globalInverseTransform) * nodeTransforms[i] * asset.getBoneOffset(skNode.boneIndex))
+				.evalTo(palette[skNode.boneIndex]);
+		}
+	}
+	return nbSampled;
+}
@@ -0,0 +1,70 @@
+#include "PoseCache.hpp"
+
+PoseCache::PoseCache(float step)
+: _step(step),
+  _frame(0),
+  _nbRequests(0),
+  _nbHits(0) {
+}
+
+PoseCache::~PoseCache() {
+}
+
+u_int32_t	PoseCache::getPose(std::shared_ptr<const ModelAsset> const &asset, u_int32_t animationId, float ticks, \
+bool skipLeaves, PoseWorkspace &workspace, BonePalette &palette, bool &hit) {
+	const aiAnimation	*animation = asset->getAnimation(animationId);
+	float				ticksPerSecond = (animation->mTicksPerSecond != 0) ? animation->mTicksPerSecond : 25.0f;
+	float				stepTicks = _step / 1000 * ticksPerSecond;
+	int64_t				bucket = static_cast<int64_t>(ticks / stepTicks);
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	++_nbRequests;
+	Entry	&entry = _entries[Key(asset.get(), animationId, bucket, skipLeaves)];
+	hit = !entry.asset.expired();
+	entry.lastFrame = _frame;
+	if (hit) {
+		++_nbHits;
+		_readyCond.wait(lock, [&entry]() { return entry.ready; });
+		lock.unlock();
+		palette = entry.palette;  // not written until the entry is removed by newFrame
+		return 0;
+	}
+	entry.asset = asset;
+	entry.ready = false;
+	lock.unlock();
+
+	u_int32_t nbNodes = evaluatePose(*asset, animationId, bucket * stepTicks, workspace, palette, skipLeaves);
+	entry.palette = palette;
+	lock.lock();
+	entry.ready = true;
+	lock.unlock();
+	_readyCond.notify_all();
+	return nbNodes;
+}
+
+void	PoseCache::newFrame() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	for (auto it = _entries.begin(); it != _entries.end();) {
+		if (it->second.lastFrame != _frame)
+			it = _entries.erase(it);
+		else
+			++it;
+	}
+	++_frame;
+	_nbRequests = 0;
+	_nbHits = 0;
+}
+
+float		PoseCache::getStep() const { return _step; }
+u_int32_t	PoseCache::getNbPoses() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _entries.size();
+}
+u_int32_t	PoseCache::getNbRequests() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _nbRequests;
+}
+u_int32_t	PoseCache::getNbHits() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _nbHits;
+}
@@ -1,6 +1,9 @@
 #include "Texture.hpp"
 #define STB_IMAGE_IMPLEMENTATION
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wtype-limits"  // unsigned >= 0 in an assert of stb (gcc -Wextra)
 #include "lib/stb_image.h"
+#pragma GCC diagnostic pop
 
 u_int32_t	textureFromFile(const std::string path, const std::string &directory, \
 bool inSpaceSRGB) {
@@ -0,0 +1,28 @@
+#include <cstdlib>
+#include <new>
+
+/*
+heap allocations counter of the benchmark (see matrixBench.cpp)
+in its own file: the compiler can not inline the replaced operators in the calling code
+and pair a new with the free of the delete
+*/
+namespace {
+	size_t	gAllocations = 0;
+
+	void *countedAlloc(size_t size) {
+		++gAllocations;
+		void *ptr = malloc(size ? size : 1);
+		if (!ptr)
+			throw std::bad_alloc();
+		return ptr;
+	}
+}
+
+size_t	getNbAllocations() { return gAllocations; }
+
+void *operator new(size_t size) { return countedAlloc(size); }
+void *operator new[](size_t size) { return countedAlloc(size); }
+void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete[](void *ptr) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { free(ptr); }
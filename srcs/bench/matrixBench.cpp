@@ -0,0 +1,600 @@
+#include "commonInclude.hpp"
+#include "KeyCursor.hpp"
+#include "Pose.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+benchmark of the matrix library and of the animation keys search (built and launched with make bench)
+usage: ./matrixBench [output.json] [min time per benchmark in ms] [model file]
+       ./matrixBench --check [model file] [poses file] -> checks only (make test)
+with a model file, the poses of its animations are evaluated too (headless, no OpenGL context, one thread):
+the poses are measured per node -> the throughput is the number of bones per second
+for each operation: ns/op, heap allocations/op and throughput (op/s)
+the json file can be kept to compare two runs
+*/
+
+/*
+--------------------------------------------------------------------------------
+allocations counter (operator new and new[], see allocCounter.cpp)
+*/
+size_t	getNbAllocations();  // since the start of the program
+
+/*
+--------------------------------------------------------------------------------
+benchmark utils
+*/
+namespace {
+	// force the compiler to compute a value that is never used
+	template<typename T>
+	inline void doNotOptimize(T const &value) { asm volatile("" : : "r,m"(value) : "memory"); }
+
+	struct BenchResult {
+		std::string	name;
+		double		nsPerOp;
+		double		allocsPerOp;
+		double		opsPerSec;
+		size_t		iterations;
+	};
+
+	/*
+	call fn(i) in a loop, the number of iterations is doubled until the loop takes at least minTime
+	fn must do opsPerCall operations (ex: a batch of 1000 points)
+	*/
+	BenchResult runBench(const std::string &name, double minTimeMs, int opsPerCall, \
+	std::function<void(size_t)> const &fn) {
+		size_t	iterations = 1;
+		double	elapsed = 0;
+		size_t	allocs = 0;
+
+		for (size_t i = 0; i < 16; ++i) {  // warm up
+			fn(i);
+		}
+		while (true) {
+			size_t allocStart = getNbAllocations();
+			auto start = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < iterations; ++i) {
+				fn(i);
+			}
+			auto end = std::chrono::steady_clock::now();
+			allocs = getNbAllocations() - allocStart;
+			elapsed = std::chrono::duration<double, std::nano>(end - start).count();
+			if (elapsed >= minTimeMs * 1e6 || iterations >= (size_t(1) << 40))
+				break;
+			iterations *= 2;
+		}
+
+		BenchResult res;
+		double ops = static_cast<double>(iterations) * opsPerCall;
+		res.name = name;
+		res.nsPerOp = elapsed / ops;
+		res.allocsPerOp = allocs / ops;
+		res.opsPerSec = ops / (elapsed * 1e-9);
+		res.iterations = iterations;
+		printf("%-28s %10.2f ns/op %8.2f allocs/op %10.2f Mop/s\n", name.c_str(), res.nsPerOp, \
+			res.allocsPerOp, res.opsPerSec * 1e-6);
+		return res;
+	}
+
+	void writeJson(const std::string &path, std::vector<BenchResult> const &results) {
+		std::ofstream	file(path);
+
+		if (!file.is_open()) {
+			std::cout << "unable to write " << path << std::endl;
+			return;
+		}
+		file << "{\n\t\"simd\": \"" << mat::simd::name() << "\",\n\t\"fast_math\": " << MAT_FAST_MATH \
+			<< ",\n\t\"benchmarks\": [\n";
+		for (size_t i = 0; i < results.size(); ++i) {
+			file << "\t\t{\"name\": \"" << results[i].name << "\", "
+				<< "\"ns_per_op\": " << results[i].nsPerOp << ", "
+				<< "\"allocs_per_op\": " << results[i].allocsPerOp << ", "
+				<< "\"ops_per_sec\": " << results[i].opsPerSec << ", "
+				<< "\"iterations\": " << results[i].iterations << "}"
+				<< ((i + 1 < results.size()) ? ",\n" : "\n");
+		}
+		file << "\t]\n}\n";
+		std::cout << "results saved in " << path << std::endl;
+	}
+
+	float randFloat(float min, float max) { return min + (max - min) * (rand() / static_cast<float>(RAND_MAX)); }
+	mat::Vec3 randVec3() { return mat::Vec3(randFloat(-10, 10), randFloat(-10, 10), randFloat(-10, 10)); }
+	mat::Quaternion randQuat() {
+		return mat::Quaternion(randFloat(-1, 1), randFloat(-1, 1), randFloat(-1, 1), randFloat(-1, 1)).normalize();
+	}
+	mat::Mat4 randTransform() {
+		return mat::Mat4().translate(randVec3()).rotateDeg(randFloat(0, 360), randVec3()).scale(randFloat(0.5, 2));
+	}
+}
+
+/*
+--------------------------------------------------------------------------------
+checks (./matrixBench --check, make test): each error is compared to its tolerance,
+the program returns 1 if one of them is above
+*/
+namespace {
+	/*
+	simd kernels compared to the scalar ones, the errors are relative:
+	mul, mulVec -> only the order of the additions (and fma) differs: error / (max |a| * max |b|) < 16 float epsilon
+	transpose -> exact
+	inverse, affineInverse -> the difference grows with the condition number of m (cond = |m| * |m-1|, max line sum)
+		the block method of the simd inverse differs from the cofactors by ~1e-3 at cond 1e3 and ~4e-2 at cond 1e4
+		(up to 100% when cond nears 1 / float epsilon): the error checked is error / (max |m-1| * cond), ~1e-6
+	*/
+	const double	SIMD_MUL_TOLERANCE = 2e-6;
+	const double	SIMD_INVERSE_TOLERANCE = 1e-5;
+
+	bool checkError(const std::string &name, double error, double tolerance) {
+		bool ok = error <= tolerance;
+		printf("%-44s %12.3g (tolerance %.3g) %s\n", name.c_str(), error, tolerance, ok ? "OK" : "FAILED");
+		return ok;
+	}
+
+	double maxAbs(const float *m, int size) {
+		double res = 0;
+		for (int i = 0; i < size; ++i)
+			res = std::max(res, static_cast<double>(std::fabs(m[i])));
+		return res;
+	}
+	double maxDiff(const float *a, const float *b, int size) {
+		double res = 0;
+		for (int i = 0; i < size; ++i)
+			res = std::max(res, std::fabs(static_cast<double>(a[i]) - b[i]));
+		return res;
+	}
+	double normInf(const float *m) {  // max of the lines sums
+		double res = 0;
+		for (int ln = 0; ln < 4; ++ln)
+			res = std::max(res, static_cast<double>(std::fabs(m[ln * 4]) + std::fabs(m[ln * 4 + 1]) \
+				+ std::fabs(m[ln * 4 + 2]) + std::fabs(m[ln * 4 + 3])));
+		return res;
+	}
+
+	/*
+	inputs of the simd checks: random transforms and matrices, the same with a flattened axis
+	or two almost equal lines (ill-conditioned)
+	*/
+	void simdInputs(std::vector<mat::Mat4> &affines, std::vector<mat::Mat4> &mats, size_t nb) {
+		for (size_t i = 0; i < nb; ++i) {
+			mat::Mat4 transform = randTransform();
+			mat::Mat4 m(false);
+			for (int j = 0; j < 16; ++j)
+				m.getData()[j] = randFloat(-1, 1);
+			affines.push_back(transform);
+			mats.push_back(m);
+
+			float flat = std::pow(10.0f, -randFloat(2, 4));
+			for (int ln = 0; ln < 3; ++ln)
+				transform[ln][i % 3] *= flat;
+			for (int col = 0; col < 4; ++col)
+				m[3][col] = m[0][col] + m[1][col] + randFloat(-1, 1) * flat;
+			affines.push_back(transform);
+			mats.push_back(m);
+		}
+	}
+
+	bool checkSimd() {
+		std::vector<mat::Mat4>	affines;
+		std::vector<mat::Mat4>	mats;
+		double					errors[5] = {0, 0, 0, 0, 0};
+		float					res[16];
+		float					ref[16];
+		bool					ok = true;
+
+		simdInputs(affines, mats, 5000);
+		mats.insert(mats.end(), affines.begin(), affines.end());
+		for (size_t i = 0; i < mats.size(); ++i) {
+			const float	*a = mats[i].getData();
+			const float	*b = mats[(i + 1) % mats.size()].getData();
+
+			mat::simd::mul(a, b, res);
+			mat::simd::mulScalar(a, b, ref);
+			errors[0] = std::max(errors[0], maxDiff(res, ref, 16) / (maxAbs(a, 16) * maxAbs(b, 16)));
+			mat::simd::mulVec(a, b, res);
+			mat::simd::mulVecScalar(a, b, ref);
+			errors[1] = std::max(errors[1], maxDiff(res, ref, 4) / (maxAbs(a, 16) * maxAbs(b, 4)));
+			mat::simd::transpose(a, res);
+			mat::simd::transposeScalar(a, ref);
+			errors[2] = std::max(errors[2], maxDiff(res, ref, 16));
+			if (mat::simd::inverse(a, res) && mat::simd::inverseScalar(a, ref)) {
+				double cond = normInf(a) * normInf(ref);
+				errors[3] = std::max(errors[3], maxDiff(res, ref, 16) / (maxAbs(ref, 16) * cond));
+			}
+		}
+		for (size_t i = 0; i < affines.size(); ++i) {
+			const float	*a = affines[i].getData();
+			if (mat::simd::affineInverse(a, res) && mat::simd::affineInverseScalar(a, ref)) {
+				double cond = normInf(a) * normInf(ref);
+				errors[4] = std::max(errors[4], maxDiff(res, ref, 16) / (maxAbs(ref, 16) * cond));
+			}
+		}
+		std::string suffix = std::string(" (") + mat::simd::name() + " / scalar)";
+		ok &= checkError("simd mul" + suffix, errors[0], SIMD_MUL_TOLERANCE);
+		ok &= checkError("simd mulVec" + suffix, errors[1], SIMD_MUL_TOLERANCE);
+		ok &= checkError("simd transpose" + suffix, errors[2], 0);
+		ok &= checkError("simd inverse / cond" + suffix, errors[3], SIMD_INVERSE_TOLERANCE);
+		ok &= checkError("simd affineInverse / cond" + suffix, errors[4], SIMD_INVERSE_TOLERANCE);
+		return ok;
+	}
+
+	/*
+	heap allocations of an expression: 0 for the fixed size types, 1 per temporary for the dynamic ones
+	(a dynamic matrix is a std::vector allocated on the heap: 2 allocations)
+	*/
+	const size_t	ALLOCS_PER_DYNAMIC = 2;
+
+	template<typename F>
+	bool checkAllocs(const std::string &name, size_t nbTemporaries, F const &fn) {
+		fn();  // first call outside of the count (static data, ...)
+		size_t	allocStart = getNbAllocations();
+		fn();
+		size_t	allocs = getNbAllocations() - allocStart;
+		bool	ok = allocs <= nbTemporaries * ALLOCS_PER_DYNAMIC;
+		printf("%-44s %4zu allocs (max %zu) %s\n", name.c_str(), allocs, nbTemporaries * ALLOCS_PER_DYNAMIC, \
+			ok ? "OK" : "FAILED");
+		return ok;
+	}
+
+	bool checkAllocations() {
+		mat::Mat4		t = mat::Mat4().translate(randVec3());
+		mat::Mat4		r = mat::Mat4().rotateDeg(randFloat(0, 360), randVec3());
+		mat::Mat4		sc = mat::Mat4().scale(randFloat(0.5, 2));
+		mat::Affine		ta(t), ra(r), sa(sc);
+		mat::Vec3		v3 = randVec3();
+		mat::Vec4		v4(v3);
+		mat::Quaternion	q = randQuat();
+		mat::Matrix<3, 4>	m34 = mat::Matrix<3, 4>(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12);
+		mat::Mat3		a = mat::Mat3(std::vector<float>({1, 2, 3, 4, 5, 6, 7, 8, 10}));
+		mat::Mat3		b = mat::Mat3(std::vector<float>({2, 0, 1, 1, 3, 0, 0, 1, 4}));
+		mat::Vec		va(3, std::vector<float>({1, 2, 3}));
+		mat::Vec		vb(3, std::vector<float>({4, 5, 6}));
+		bool			ok = true;
+
+		/* fixed size: no allocation */
+		ok &= checkAllocs("Mat4 T * R * S", 0, [&]() { doNotOptimize(t * r * sc); });
+		ok &= checkAllocs("Mat4 T * R * S * Vec4", 0, [&]() { doNotOptimize(t * r * sc * v4); });
+		ok &= checkAllocs("Mat4 += *= -=", 0, [&]() { mat::Mat4 m = t; m += r; m *= sc; m -= t; doNotOptimize(m); });
+		ok &= checkAllocs("Mat4 inverse, transpose", 0, [&]() { doNotOptimize(r.inverse().transpose()); });
+		ok &= checkAllocs("Affine T * R * S", 0, [&]() { doNotOptimize(ta * ra * sa); });
+		ok &= checkAllocs("Affine *=", 0, [&]() { mat::Affine m = ta; m *= ra; doNotOptimize(m); });
+		ok &= checkAllocs("Affine chain (3) lazy", 0, [&]() {
+			mat::Affine res;
+			(mat::expr::lazy(ta) * ra * sa).evalTo(res);
+			doNotOptimize(res);
+		});
+		ok &= checkAllocs("Vec3 a + b * 2 - a", 0, [&]() { doNotOptimize(v3 + v3 * 2.0f - v3); });
+		ok &= checkAllocs("Vec3 += -= *=", 0, [&]() { mat::Vec3 v = v3; v += v3; v -= v3; v *= 2.0f; doNotOptimize(v); });
+		ok &= checkAllocs("Quaternion q * q * v", 0, [&]() { doNotOptimize(q * q * v3); });
+		ok &= checkAllocs("Matrix<3, 4> * Matrix<4, 3>", 0, [&]() { doNotOptimize(m34 * m34.transpose()); });
+
+		/* dynamic size: the first operand (copy) is the result of the chain, the next operators work in place */
+		ok &= checkAllocs("Mat3 a * 2 + b - 1", 1, [&]() { doNotOptimize((a * 2.0f + b - 1.0f).get(0, 0)); });
+		ok &= checkAllocs("Mat3 a * b", 1, [&]() { doNotOptimize((a * b).get(0, 0)); });
+		ok &= checkAllocs("Mat3 a * b * b", 2, [&]() { doNotOptimize((a * b * b).get(0, 0)); });
+		ok &= checkAllocs("Mat3 += -= *= (scalar)", 0, [&]() { a += b; a -= b; a *= 1.0f; doNotOptimize(a.get(0, 0)); });
+		ok &= checkAllocs("Vec a + b - a", 1, [&]() { doNotOptimize((va + vb - va).x); });
+		ok &= checkAllocs("Vec += -=", 0, [&]() { va += vb; va -= vb; doNotOptimize(va.x); });
+		ok &= checkAllocs("Vec normalize", 1, [&]() { doNotOptimize(va.normalize().x); });
+		ok &= checkAllocs("Vec move, moved-from = Vec", 1, [&]() {
+			mat::Vec moved(std::move(va));
+			va = moved;  // new data for the moved-from vec
+			doNotOptimize(va.x + moved.x);
+		});
+		return ok;
+	}
+
+	/*
+	poses of all the animations of a model, one frame every 1/60 s:
+	- evaluatePose against evaluatePoseScalar (simd batches and static cache against node by node)
+	- with a poses file: the default build saves its palettes in it, the fast math build (MAT_FAST_MATH=1)
+	  compares its palettes with them (make test runs both)
+	- with ANIMATION_COMPRESSION: max error of the compressed clips against ANIMATION_COMPRESSION_TOLERANCE
+	error of a palette: max error of a skinned vertex relative to the model size
+	(|rotation difference| + |translation difference| / size)
+	*/
+	const double	POSE_TOLERANCE = 1e-4;
+	const double	FAST_MATH_POSE_TOLERANCE = 1e-3;
+
+	double paletteError(BonePalette const &palette, BonePalette const &ref, u_int32_t nbBones, double size) {
+		double res = 0;
+		for (u_int32_t i = 0; i < nbBones; ++i) {
+			const float	*a = palette[i].getData();
+			const float	*b = ref[i].getData();
+			for (int ln = 0; ln < 3; ++ln) {
+				double err = std::fabs(static_cast<double>(a[ln * 4 + 3]) - b[ln * 4 + 3]) / size;
+				for (int col = 0; col < 3; ++col)
+					err += std::fabs(static_cast<double>(a[ln * 4 + col]) - b[ln * 4 + col]);
+				res = std::max(res, err);
+			}
+		}
+		return res;
+	}
+
+	bool checkPoses(const std::string &path, const std::string &posesPath) {
+		std::shared_ptr<const ModelAsset>	asset;
+		try {
+			asset = ModelAsset::load(path, false);
+		}
+		catch (std::exception const &e) {
+			std::cout << "unable to load " << path << ": " << e.what() << std::endl;
+			return false;
+		}
+		std::fstream	posesFile;
+		if (!posesPath.empty()) {
+			posesFile.open(posesPath, std::ios::binary | (MAT_FAST_MATH ? std::ios::in : std::ios::out));
+			if (!posesFile.is_open()) {
+				std::cout << "unable to open " << posesPath << (MAT_FAST_MATH ? " (saved by the default build)" : "") \
+					<< std::endl;
+				return false;
+			}
+		}
+
+		PoseWorkspace	workspace;
+		PoseWorkspace	scalarWorkspace;
+		BonePalette		palette;
+		BonePalette		ref;
+		u_int32_t		nbBones = asset->getBoneMap().size();
+		mat::Vec3		extent = asset->getMaxPos() - asset->getMinPos();
+		double			size = std::max(1e-6f, std::sqrt(extent.dot(extent)));
+		bool			ok = true;
+		for (u_int32_t id = 0; id < asset->getNbAnimations(); ++id) {
+			const aiAnimation	*animation = asset->getAnimation(id);
+			float				ticksPerSecond = (animation->mTicksPerSecond != 0) ? animation->mTicksPerSecond : 25.0f;
+			double				errors[2] = {0, 0};
+			for (float time = 0; time <= animation->mDuration; time += ticksPerSecond / 60.0f) {
+				evaluatePose(*asset, id, time, workspace, palette);
+				evaluatePoseScalar(*asset, id, time, scalarWorkspace, ref);
+				errors[0] = std::max(errors[0], paletteError(palette, ref, nbBones, size));
+				if (!posesFile.is_open())
+					continue;
+				if (MAT_FAST_MATH) {
+					posesFile.read(reinterpret_cast<char *>(ref.data()), nbBones * sizeof(mat::Affine));
+					if (!posesFile) {
+						std::cout << posesPath << " does not match " << path << std::endl;
+						return false;
+					}
+					errors[1] = std::max(errors[1], paletteError(palette, ref, nbBones, size));
+				}
+				else {
+					posesFile.write(reinterpret_cast<const char *>(palette.data()), nbBones * sizeof(mat::Affine));
+				}
+			}
+			std::string suffix = " anim " + std::to_string(id);
+			ok &= checkError("evaluatePose / scalar" + suffix, errors[0], POSE_TOLERANCE);
+			if (MAT_FAST_MATH && posesFile.is_open())
+				ok &= checkError("evaluatePose fast math / default" + suffix, errors[1], FAST_MATH_POSE_TOLERANCE);
+			// compressed clip (ANIMATION_COMPRESSION): within the tolerances of ModelAsset::compressAnimations
+			if (const CompressedAnimation *compressed = asset->getCompressedAnimation(id)) {
+				ClipError	error = compressed->getMaxError();
+				float		maxExtent = std::max(extent.x, std::max(extent.y, extent.z));
+				ok &= checkError("compression translation / size" + suffix, \
+					error.translation / std::max(1e-6f, maxExtent), ANIMATION_COMPRESSION_TOLERANCE);
+				ok &= checkError("compression rotation (rad)" + suffix, error.rotation, ANIMATION_COMPRESSION_TOLERANCE);
+				ok &= checkError("compression scaling" + suffix, error.scaling, ANIMATION_COMPRESSION_TOLERANCE);
+			}
+		}
+		if (!MAT_FAST_MATH && posesFile.is_open())
+			std::cout << "poses saved in " << posesPath << std::endl;
+		return ok;
+	}
+
+	int runChecks(int ac, char **av) {
+		bool	ok = true;
+
+		srand(42);
+		std::cout << "simd: " << mat::simd::name() << ", fast math: " << MAT_FAST_MATH << std::endl;
+		ok &= checkSimd();
+		ok &= checkAllocations();
+		if (ac > 2)
+			ok &= checkPoses(av[2], (ac > 3) ? av[3] : "");
+		std::cout << (ok ? "all checks passed" : "CHECKS FAILED") << std::endl;
+		return ok ? 0 : 1;
+	}
+}
+
+/*
+--------------------------------------------------------------------------------
+benchmarks
+*/
+int main(int ac, char **av) {
+	if (ac > 1 && std::string(av[1]) == "--check")
+		return runChecks(ac, av);
+	std::string		jsonPath = (ac > 1) ? av[1] : "bench.json";
+	double			minTime = (ac > 2) ? atof(av[2]) : 200;
+	const size_t	N = 256;  // size of the inputs sets (power of 2)
+	std::vector<BenchResult> results;
+
+	srand(42);
+	std::vector<mat::Mat4>			mats(N);
+	std::vector<mat::Affine>		affines(N);
+	std::vector<mat::Vec3>			vecs(N);
+	std::vector<mat::Vec4>			vecs4(N);
+	std::vector<mat::Quaternion>	quats(N);
+	std::vector<aiMatrix4x4>		aiMats(N);
+	std::vector<float>				steps(N);
+	for (size_t i = 0; i < N; ++i) {
+		mats[i] = randTransform();
+		affines[i] = mat::Affine(mats[i]);
+		vecs[i] = randVec3();
+		vecs4[i] = mat::Vec4(vecs[i]);
+		quats[i] = randQuat();
+		aiMats[i] = mat4ToAi(mats[i]);
+		steps[i] = randFloat(0, 1);
+	}
+	// batches: the inputs of the matrix i are at i and N + i
+	std::vector<mat::Affine>		affinesOut(N);
+	std::vector<const mat::Affine*>	affinePtrs(2 * N);
+	std::vector<mat::Affine*>		affineOut(N);
+	std::vector<float>				soa(4 * N);
+	for (size_t i = 0; i < 2 * N; ++i) {
+		affinePtrs[i] = &affines[(i * 7) % N];
+	}
+	for (size_t i = 0; i < N; ++i) {
+		affineOut[i] = &affinesOut[i];
+		soa[i] = quats[i].vec.x;
+		soa[N + i] = quats[i].vec.y;
+		soa[2 * N + i] = quats[i].vec.z;
+		soa[3 * N + i] = quats[i].w;
+	}
+	const float			*trs[3] = {soa.data(), soa.data() + N, soa.data() + 2 * N};
+	mat::QuaternionSoA	rotations = {soa.data(), soa.data() + N, soa.data() + 2 * N, soa.data() + 3 * N};
+	mat::Vec3Array	points(10000);
+	mat::Vec3Array	pointsOut;
+	for (int i = 0; i < points.getSize(); ++i) {
+		points.set(i, randVec3());
+	}
+	mat::Mat3		mat3 = mat::Mat3(std::vector<float>({1, 2, 3, 4, 5, 6, 7, 8, 10}));
+	mat::Vec		dynVec(3, std::vector<float>({1, 2, 3}));
+
+	std::cout << "simd: " << mat::simd::name() << ", fast math: " << MAT_FAST_MATH << std::endl;
+
+	/* Mat4 */
+	results.push_back(runBench("Mat4 * Mat4", minTime, 1, [&](size_t i) {
+		doNotOptimize(mats[i % N] * mats[(i + 1) % N]);
+	}));
+	results.push_back(runBench("Mat4 * Vec4", minTime, 1, [&](size_t i) {
+		doNotOptimize(mats[i % N] * vecs4[(i + 1) % N]);
+	}));
+	results.push_back(runBench("Mat4 inverse", minTime, 1, [&](size_t i) {
+		doNotOptimize(mats[i % N].inverse());
+	}));
+	results.push_back(runBench("Mat4 affineInverse", minTime, 1, [&](size_t i) {
+		doNotOptimize(mats[i % N].affineInverse());
+	}));
+	results.push_back(runBench("Mat4 transpose", minTime, 1, [&](size_t i) {
+		doNotOptimize(mats[i % N].transpose());
+	}));
+	results.push_back(runBench("Affine * Affine", minTime, 1, [&](size_t i) {
+		doNotOptimize(affines[i % N] * affines[(i + 1) % N]);
+	}));
+	results.push_back(runBench("Affine chain (3) lazy", minTime, 1, [&](size_t i) {
+		mat::Affine res;
+		(mat::expr::lazy(affines[i % N]) * affines[(i + 1) % N] * affines[(i + 2) % N]).evalTo(res);
+		doNotOptimize(res);
+	}));
+	results.push_back(runBench("Affine mulBatch", minTime, N, [&](size_t) {
+		mat::mulBatch(affinePtrs.data(), affinePtrs.data() + N, affineOut.data(), N);
+		doNotOptimize(affinesOut[0]);
+	}));
+	results.push_back(runBench("Affine composeBatch", minTime, N, [&](size_t) {
+		mat::composeBatch(trs, rotations, trs, affineOut.data(), N);
+		doNotOptimize(affinesOut[0]);
+	}));
+
+	/* vectors */
+	results.push_back(runBench("Vec3 normalize", minTime, 1, [&](size_t i) {
+		doNotOptimize(vecs[i % N].normalize());
+	}));
+	results.push_back(runBench("Vec3 dot", minTime, 1, [&](size_t i) {
+		doNotOptimize(mat::dot(vecs[i % N], vecs[(i + 1) % N]));
+	}));
+	results.push_back(runBench("Vec3 cross", minTime, 1, [&](size_t i) {
+		doNotOptimize(mat::cross(vecs[i % N], vecs[(i + 1) % N]));
+	}));
+	results.push_back(runBench("Vec3Array transformPoints", minTime, points.getSize(), [&](size_t i) {
+		mat::transformPoints(mats[i % N], points, pointsOut);
+		doNotOptimize(pointsOut.getX()[0]);
+	}));
+
+	/* dynamic size matrix (heap) */
+	results.push_back(runBench("Vec normalize (dynamic)", minTime, 1, [&](size_t) {
+		doNotOptimize(dynVec.normalize().x);
+	}));
+	results.push_back(runBench("Mat3 * Mat3 (dynamic)", minTime, 1, [&](size_t) {
+		doNotOptimize((mat3 * mat3).get(0, 0));
+	}));
+
+	/* quaternions */
+	results.push_back(runBench("Quaternion slerp", minTime, 1, [&](size_t i) {
+		doNotOptimize(mat::slerp(quats[i % N], quats[(i + 1) % N], steps[i % N]));
+	}));
+	results.push_back(runBench("Quaternion nlerp", minTime, 1, [&](size_t i) {
+		doNotOptimize(mat::nlerp(quats[i % N], quats[(i + 1) % N], steps[i % N]));
+	}));
+	results.push_back(runBench("Quaternion toMatrix", minTime, 1, [&](size_t i) {
+		doNotOptimize(quats[i % N].toMatrix());
+	}));
+
+	/* animation keys: one frame of forward playback (60 fps on keys sampled at 30 fps) */
+	for (u_int32_t nbKeys : {100u, 1000u, 10000u, 100000u}) {
+		std::vector<aiVectorKey>	keys(nbKeys);
+		u_int32_t					cursor = 0;
+		for (u_int32_t k = 0; k < nbKeys; ++k) {
+			keys[k].mTime = k;
+		}
+		auto frameTime = [nbKeys](size_t i) { return static_cast<float>((i % (2 * (nbKeys - 1))) * 0.5); };
+		std::string suffix = " (" + std::to_string(nbKeys) + " keys)";
+
+		results.push_back(runBench("findKey cursor" + suffix, minTime, 1, [&](size_t i) {
+			findKey(frameTime(i), keys.data(), nbKeys, cursor);
+			doNotOptimize(cursor);
+		}));
+		// the linear scan does not depend on the previous frame: the frames are spread on the whole clip
+		results.push_back(runBench("findKey linear" + suffix, minTime, 1, [&](size_t i) {
+			float		time = frameTime(i * 7919);
+			u_int32_t	k = 0;
+			while (k < nbKeys - 2 && time > static_cast<float>(keys[k + 1].mTime))
+				++k;
+			doNotOptimize(k);
+		}));
+	}
+
+	/* poses of a model: one frame of forward playback at 60 fps per call */
+	if (ac > 3) {
+		std::shared_ptr<const ModelAsset>	asset = ModelAsset::load(av[3], false);
+		PoseWorkspace						workspace;
+		BonePalette							palette;
+		for (u_int32_t id = 0; id < asset->getNbAnimations(); ++id) {
+			const aiAnimation	*animation = asset->getAnimation(id);
+			float				ticksPerSecond = (animation->mTicksPerSecond != 0) ? animation->mTicksPerSecond : 25.0f;
+			float				duration = animation->mDuration;
+			u_int32_t			nbNodes = asset->getSkeleton().size();
+			std::string			suffix = " anim " + std::to_string(id) + " (" + std::to_string(nbNodes) + " nodes)";
+			results.push_back(runBench("evaluatePoseScalar" + suffix, minTime, nbNodes, [&](size_t i) {
+				float time = (duration > 0) ? std::fmod(i * ticksPerSecond / 60.0f, duration) : 0;
+				evaluatePoseScalar(*asset, id, time, workspace, palette);
+				doNotOptimize(palette[0]);
+			}));
+			results.push_back(runBench("evaluatePose" + suffix, minTime, nbNodes, [&](size_t i) {
+				float time = (duration > 0) ? std::fmod(i * ticksPerSecond / 60.0f, duration) : 0;
+				evaluatePose(*asset, id, time, workspace, palette);
+				doNotOptimize(palette[0]);
+			}));
+		}
+		// two clips (the first two animations) blended: compare with two evaluatePose
+		if (asset->getNbAnimations() > 0) {
+			BlendWorkspace		blendWorkspace;
+			u_int32_t			other = (asset->getNbAnimations() > 1) ? 1 : 0;
+			float				duration0 = asset->getAnimation(0)->mDuration;
+			float				duration1 = asset->getAnimation(other)->mDuration;
+			u_int32_t			nbNodes = asset->getSkeleton().size();
+			std::string			suffix = " anim 0 + " + std::to_string(other) + " (" + std::to_string(nbNodes) + " nodes)";
+			for (bool additive : {false, true}) {
+				results.push_back(runBench(std::string(additive ? "evaluateBlendedPose additive" \
+				: "evaluateBlendedPose crossfade") + suffix, minTime, nbNodes, [&](size_t i) {
+					PoseLayer	layers[2] = {
+						{0, (duration0 > 0) ? std::fmod(i * 0.4f, duration0) : 0, 1.0f, false},
+						{other, (duration1 > 0) ? std::fmod(i * 0.4f, duration1) : 0, 0.5f, additive}
+					};
+					evaluateBlendedPose(*asset, layers, 2, blendWorkspace, palette);
+					doNotOptimize(palette[0]);
+				}));
+			}
+		}
+	}
+
+	/* assimp conversion */
+	results.push_back(runBench("aiToMat4", minTime, 1, [&](size_t i) {
+		doNotOptimize(aiToMat4(aiMats[i % N]));
+	}));
+
+	writeJson(jsonPath, results);
+	return 0;
+}
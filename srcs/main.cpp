@@ -4,6 +4,7 @@
 #include "Model.hpp"
 #include "Matrix.hpp"
 #include "Skybox.hpp"
+#include "JobPool.hpp"
 #include <chrono>
 #include <unistd.h>
 
@@ -20,6 +21,15 @@ void	gameLoop(GLFWwindow *window, Camera &cam, Shader &skyboxSh, Shader &modelSh
 	tWinUser	*winU;
 	std::chrono::milliseconds time_start;
 	bool firstLoop = true;
+	JobPool		jobPool(JobPool::defaultNbWorkers());  // animations update
+	PoseCache	poseCache(ANIMATION_POSE_CACHE_STEP);
+	PoseCache	*sharedPoses = (ANIMATION_POSE_CACHE_STEP > 0) ? &poseCache : nullptr;
+	u_int32_t	nbFrames = 0;
+	u_int32_t	nbEvaluatedNodes = 0;
+	u_int32_t	nbEvaluatedBones = 0;
+	u_int32_t	nbCachedBones = 0;
+	u_int32_t	nbPoseRequests = 0;
+	u_int32_t	nbPoseHits = 0;
 
 	winU = (tWinUser *)glfwGetWindowUserPointer(window);
 
@@ -63,6 +73,42 @@ void	gameLoop(GLFWwindow *window, Camera &cam, Shader &skyboxSh, Shader &modelSh
 		cubeSh.setVec3("viewPos", cam.pos.x, cam.pos.y, cam.pos.z);
 
 
+		// animations of all the models in parallel (no OpenGL call), then draw them on this thread
+		poseCache.newFrame();
+		jobPool.parallelFor(models.size(), [&models, &cam, sharedPoses](u_int32_t i) {
+			models[i]->update(cam.pos, sharedPoses);
+		});
+		// animation counters in the window title, updated every second
+		for (u_int32_t i=0; i < models.size(); i++) {
+			nbEvaluatedNodes += models[i]->getNbEvaluatedNodes();
+			nbEvaluatedBones += models[i]->getNbEvaluatedBones();
+			nbCachedBones += models[i]->getNbCachedBones();
+		}
+		nbPoseRequests += poseCache.getNbRequests();
+		nbPoseHits += poseCache.getNbHits();
+		if (++nbFrames >= FPS) {
+			u_int32_t nbModelsLod[Model::NB_LOD] = {0};
+			for (u_int32_t i=0; i < models.size(); i++)
+				++nbModelsLod[models[i]->getAnimationLod()];
+			u_int32_t nbBones = nbEvaluatedBones + nbCachedBones;
+			std::string title = "humanGl | nodes sampled: " + std::to_string(nbEvaluatedNodes / nbFrames) \
+				+ "/frame | bones evaluated: " + std::to_string(nbEvaluatedBones / nbFrames) \
+				+ "/frame, cached: " + std::to_string(nbCachedBones / nbFrames) \
+				+ "/frame (" + std::to_string(nbBones ? 100 * nbCachedBones / nbBones : 0) + "%)" \
+				+ " | shared poses: " + std::to_string(nbPoseHits / nbFrames) + "/frame (" \
+				+ std::to_string(nbPoseRequests ? 100 * nbPoseHits / nbPoseRequests : 0) + "% hits)" \
+				+ " | models full: " + std::to_string(nbModelsLod[Model::LOD_FULL]) \
+				+ ", throttled: " + std::to_string(nbModelsLod[Model::LOD_THROTTLE]) \
+				+ ", no leaves: " + std::to_string(nbModelsLod[Model::LOD_NO_LEAVES]) \
+				+ ", frozen: " + std::to_string(nbModelsLod[Model::LOD_FROZEN]);
+			glfwSetWindowTitle(window, title.c_str());
+			nbFrames = 0;
+			nbEvaluatedNodes = 0;
+			nbEvaluatedBones = 0;
+			nbCachedBones = 0;
+			nbPoseRequests = 0;
+			nbPoseHits = 0;
+		}
 		// to move model, change matrix: objModel.getModel()
 		for (u_int32_t i=0; i < models.size(); i++) {
 			models[i]->draw();
@@ -0,0 +1,201 @@
+#include "Affine.hpp"
+#include "MatrixSimd.hpp"
+#include <cstring>
+
+#if MAT_SIMD >= MAT_SIMD_SSE
+	#include <immintrin.h>
+#endif
+
+using namespace mat;
+
+/*
+--------------------------------------------------------------------------------
+batch kernels
+*/
+namespace {
+#if MAT_SIMD >= MAT_SIMD_SSE
+	// 4 matrices in SoA: m[i] is the coefficient i (row major) of the 4 matrices
+	struct Affine4 {
+		__m128 m[12];
+	};
+
+	inline void load4(const Affine *const *src, Affine4 &dst) {
+		for (int ln=0; ln < 3; ln++) {
+			__m128 r0 = _mm_load_ps(src[0]->getData() + ln * 4);
+			__m128 r1 = _mm_load_ps(src[1]->getData() + ln * 4);
+			__m128 r2 = _mm_load_ps(src[2]->getData() + ln * 4);
+			__m128 r3 = _mm_load_ps(src[3]->getData() + ln * 4);
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			dst.m[ln * 4] = r0;
+			dst.m[ln * 4 + 1] = r1;
+			dst.m[ln * 4 + 2] = r2;
+			dst.m[ln * 4 + 3] = r3;
+		}
+	}
+
+	inline void store4(Affine4 const &src, Affine *const *dst) {
+		for (int ln=0; ln < 3; ln++) {
+			__m128 r0 = src.m[ln * 4];
+			__m128 r1 = src.m[ln * 4 + 1];
+			__m128 r2 = src.m[ln * 4 + 2];
+			__m128 r3 = src.m[ln * 4 + 3];
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			_mm_store_ps(dst[0]->getData() + ln * 4, r0);
+			_mm_store_ps(dst[1]->getData() + ln * 4, r1);
+			_mm_store_ps(dst[2]->getData() + ln * 4, r2);
+			_mm_store_ps(dst[3]->getData() + ln * 4, r3);
+		}
+	}
+
+	// same order of the operations as simd::mulAffine
+	inline void mul4(Affine4 const &a, Affine4 const &b, Affine4 &out) {
+		for (int ln=0; ln < 3; ln++) {
+			for (int col=0; col < 4; col++) {
+				__m128 r = _mm_mul_ps(a.m[ln * 4], b.m[col]);
+				r = _mm_add_ps(r, _mm_mul_ps(a.m[ln * 4 + 1], b.m[4 + col]));
+				r = _mm_add_ps(r, _mm_mul_ps(a.m[ln * 4 + 2], b.m[8 + col]));
+				out.m[ln * 4 + col] = (col == 3) ? _mm_add_ps(r, a.m[ln * 4 + 3]) : r;
+			}
+		}
+	}
+
+	// same order of the operations as Quaternion::toMatrix and Affine(T, R, S)
+	inline void compose4(const float *const translations[3], const QuaternionSoA &rotations, \
+	const float *const scales[3], int i, Affine4 &out) {
+		__m128 x = _mm_loadu_ps(rotations.x + i), y = _mm_loadu_ps(rotations.y + i);
+		__m128 z = _mm_loadu_ps(rotations.z + i), w = _mm_loadu_ps(rotations.w + i);
+		__m128 sx = _mm_loadu_ps(scales[0] + i), sy = _mm_loadu_ps(scales[1] + i);
+		__m128 sz = _mm_loadu_ps(scales[2] + i);
+		__m128 one = _mm_set1_ps(1.0f);
+
+		__m128 n = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(w, w), _mm_mul_ps(x, x)), _mm_mul_ps(y, y)), \
+			_mm_mul_ps(z, z));
+		__m128 s = _mm_and_ps(_mm_cmpgt_ps(n, _mm_setzero_ps()), _mm_div_ps(_mm_set1_ps(2.0f), n));
+		__m128 xs = _mm_mul_ps(x, s), ys = _mm_mul_ps(y, s), zs = _mm_mul_ps(z, s);
+		__m128 wx = _mm_mul_ps(w, xs), wy = _mm_mul_ps(w, ys), wz = _mm_mul_ps(w, zs);
+		__m128 xx = _mm_mul_ps(x, xs), xy = _mm_mul_ps(x, ys), xz = _mm_mul_ps(x, zs);
+		__m128 yy = _mm_mul_ps(y, ys), yz = _mm_mul_ps(y, zs), zz = _mm_mul_ps(z, zs);
+
+		out.m[0] = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx);
+		out.m[1] = _mm_mul_ps(_mm_sub_ps(xy, wz), sy);
+		out.m[2] = _mm_mul_ps(_mm_add_ps(xz, wy), sz);
+		out.m[3] = _mm_loadu_ps(translations[0] + i);
+		out.m[4] = _mm_mul_ps(_mm_add_ps(xy, wz), sx);
+		out.m[5] = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy);
+		out.m[6] = _mm_mul_ps(_mm_sub_ps(yz, wx), sz);
+		out.m[7] = _mm_loadu_ps(translations[1] + i);
+		out.m[8] = _mm_mul_ps(_mm_sub_ps(xz, wy), sx);
+		out.m[9] = _mm_mul_ps(_mm_add_ps(yz, wx), sy);
+		out.m[10] = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz);
+		out.m[11] = _mm_loadu_ps(translations[2] + i);
+	}
+#endif
+}
+
+Affine::Affine() {
+	for (int i=0; i < 12; i++) {
+		_data[i] = (i % 5 == 0) ? 1 : 0;
+	}
+}
+Affine::Affine(const Mat4 &m) {
+	memcpy(_data, m.getData(), sizeof(_data));
+}
+
+/*
+rotation matrix of the quaternion with each column multiplied by the scale
+and the translation in the last column
+*/
+Affine::Affine(const Vec3 &translation, const Quaternion &rotation, const Vec3 &scale) {
+	Mat4 rot = rotation.toMatrix();
+	for (int ln=0; ln < 3; ln++) {
+		_data[ln * 4] = rot[ln][0] * scale.x;
+		_data[ln * 4 + 1] = rot[ln][1] * scale.y;
+		_data[ln * 4 + 2] = rot[ln][2] * scale.z;
+	}
+	_data[3] = translation.x;
+	_data[7] = translation.y;
+	_data[11] = translation.z;
+}
+
+Affine Affine::inverse() const {
+	float res[16];
+	if (!simd::affineInverse(_data, res)) {
+		throw std::invalid_argument("matrix is not invertible");
+	}
+	Affine ret;
+	memcpy(ret._data, res, sizeof(ret._data));
+	return ret;
+}
+
+Affine &Affine::operator*=(const Affine &other) {
+	simd::mulAffine(_data, other._data, _data);
+	return *this;
+}
+
+Mat4 Affine::toMat4() const {
+	Mat4 res;  // identity, the last line is already 0 0 0 1
+	memcpy(res.getData(), _data, sizeof(_data));
+	return res;
+}
+
+Vec3 Affine::transformPoint(const Vec3 &p) const {
+	return Vec3(
+		_data[0] * p.x + _data[1] * p.y + _data[2] * p.z + _data[3],
+		_data[4] * p.x + _data[5] * p.y + _data[6] * p.z + _data[7],
+		_data[8] * p.x + _data[9] * p.y + _data[10] * p.z + _data[11]);
+}
+Vec3 Affine::transformVector(const Vec3 &v) const {
+	return Vec3(
+		_data[0] * v.x + _data[1] * v.y + _data[2] * v.z,
+		_data[4] * v.x + _data[5] * v.y + _data[6] * v.z,
+		_data[8] * v.x + _data[9] * v.y + _data[10] * v.z);
+}
+
+namespace mat {
+	std::ostream &operator<<(std::ostream &out, const Affine &m) { return out << m.toMat4(); }
+	Affine operator*(const Affine &m, const Affine &other) {
+		Affine res;
+		simd::mulAffine(m._data, other._data, res._data);
+		return res;
+	}
+	bool operator==(const Affine &m, const Affine &other) {
+		for (int i=0; i < 12; i++) {
+			if (m._data[i] != other._data[i])
+				return false;
+		}
+		return true;
+	}
+
+	void mulBatch(const Affine *const *a, const Affine *const *b, Affine *const *out, int count) {
+		int i = 0;
+	#if MAT_SIMD >= MAT_SIMD_SSE
+		for (; i + 4 <= count; i += 4) {
+			Affine4 a4, b4, res;
+			load4(a + i, a4);
+			load4(b + i, b4);
+			mul4(a4, b4, res);
+			store4(res, out + i);
+		}
+	#endif
+		for (; i < count; i++) {
+			simd::mulAffine(a[i]->getData(), b[i]->getData(), out[i]->getData());
+		}
+	}
+
+	void composeBatch(const float *const translations[3], const QuaternionSoA &rotations, \
+	const float *const scales[3], Affine *const *out, int count) {
+		int i = 0;
+	#if MAT_SIMD >= MAT_SIMD_SSE
+		for (; i + 4 <= count; i += 4) {
+			Affine4 res;
+			compose4(translations, rotations, scales, i, res);
+			store4(res, out + i);
+		}
+	#endif
+		for (; i < count; i++) {
+			*out[i] = Affine(Vec3(translations[0][i], translations[1][i], translations[2][i]), \
+				Quaternion(rotations.w[i], rotations.x[i], rotations.y[i], rotations.z[i]), \
+				Vec3(scales[0][i], scales[1][i], scales[2][i]));
+		}
+	}
+}
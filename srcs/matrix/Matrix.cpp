@@ -1,6 +1,10 @@
 #include "Matrix.hpp"
+#include "MatrixSimd.hpp"
+#include "FastMath.hpp"
 #include <cmath>
+#include <new>
 #include <stdio.h>
+#include <utility>
 
 using namespace mat;
 
@@ -8,32 +12,50 @@ using namespace mat;
 --------------------------------------------------------------------------------
 Vec2
 */
-Vec2::Vec2() : Vec(2) {}
-Vec2::Vec2(const Vec2 &vec) : Vec(vec.getSize(), vec.getData()) {}
-Vec2::Vec2(const BaseMat &mat) : Vec(2, mat.getData()) {}
-Vec2::Vec2(std::vector<float> data) : Vec(2, data) {}
-Vec2::Vec2(float _x, float _y) : Vec(2, std::vector<float>{_x, _y}) {}
+Vec2::Vec2() : x(0), y(0) {}
+Vec2::Vec2(const BaseMat &mat) : Vec2(mat.getData()) {}
+Vec2::Vec2(std::vector<float> values) {
+	if (values.size() < 2) {
+		throw std::invalid_argument("wrong vector size");
+	}
+	for (int i=0; i < 2; i++) {
+		data[i] = values[i];
+	}
+}
+Vec2::Vec2(float _x, float _y) : x(_x), y(_y) {}
 
-namespace mat {
-	Vec2 operator*(const Vec2 &v, const float other) { return Vec2(BaseMat(v) * other); }
-	Vec2 operator+(const Vec2 &v, const float other) { return Vec2(BaseMat(v) + other); }
-	Vec2 operator+(const Vec2 &v, const BaseMat other) { return Vec2(BaseMat(v) + other); }
-	Vec2 operator-(const Vec2 &v, const float other) { return Vec2(BaseMat(v) - other); }
-	Vec2 operator-(const Vec2 &v, const BaseMat other) { return Vec2(BaseMat(v) - other); }
+float Vec2::dot(const Vec2 &v) const { return x * v.x + y * v.y; }
+Vec2 Vec2::normalize() const {
+	float len = x * x + y * y;
+	if (len > 0) {
+		float inv = math::invSqrt(len);
+		return Vec2(x * inv, y * inv);
+	}
+	return *this;
 }
 
-Vec2::~Vec2() {}
+Vec2::operator BaseMat() const { return BaseMat(2, 1, std::vector<float>(data, data + 2)); }
+
+namespace mat {
+	std::ostream &operator<<(std::ostream &out, const Vec2 &v) { return out << BaseMat(v); }
+}
 
 /*
 --------------------------------------------------------------------------------
 Vec3
 */
-Vec3::Vec3() : Vec(3) {}
-Vec3::Vec3(const Vec3 &vec) : Vec(vec.getSize(), vec.getData()) {}
-Vec3::Vec3(const Vec4 &vec4) : Vec(3, std::vector<float>{vec4.x, vec4.y, vec4.z}) {}
-Vec3::Vec3(const BaseMat &mat) : Vec(3, mat.getData()) {}
-Vec3::Vec3(std::vector<float> data) : Vec(3, data) {}
-Vec3::Vec3(float _x, float _y, float _z) : Vec(3, std::vector<float>{_x, _y, _z}) {}
+Vec3::Vec3() : x(0), y(0), z(0) {}
+Vec3::Vec3(const Vec4 &vec4) : x(vec4.x), y(vec4.y), z(vec4.z) {}
+Vec3::Vec3(const BaseMat &mat) : Vec3(mat.getData()) {}
+Vec3::Vec3(std::vector<float> values) {
+	if (values.size() < 3) {
+		throw std::invalid_argument("wrong vector size");
+	}
+	for (int i=0; i < 3; i++) {
+		data[i] = values[i];
+	}
+}
+Vec3::Vec3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
 
 Vec3 Vec3::cross(const Vec3 &v) const
 {
@@ -45,61 +67,68 @@ Vec3 Vec3::cross(const Vec3 &v) const
 
 	return c;
 }
-float Vec3::dot(const Vec3 &v) const
-{
-	float res = 0;
-	for (int i=0; i < getSize(); i++) {
-		res += get(i) * v.get(i);
+Vec3 Vec3::normalize() const {
+	float len = x * x + y * y + z * z;
+	if (len > 0) {
+		float inv = math::invSqrt(len);
+		return Vec3(x * inv, y * inv, z * inv);
 	}
-	return res;
+	return *this;
 }
 
+Vec3::operator BaseMat() const { return BaseMat(3, 1, std::vector<float>(data, data + 3)); }
+
 namespace mat {
-	Vec3 operator*(const Vec3 &v, const float other) { return Vec3(BaseMat(v) * other); }
-	Vec3 operator+(const Vec3 &v, const float other) { return Vec3(BaseMat(v) + other); }
-	Vec3 operator+(const Vec3 &v, const BaseMat other) { return Vec3(BaseMat(v) + other); }
-	Vec3 operator-(const Vec3 &v, const float other) { return Vec3(BaseMat(v) - other); }
-	Vec3 operator-(const Vec3 &v, const BaseMat other) { return Vec3(BaseMat(v) - other); }
+	std::ostream &operator<<(std::ostream &out, const Vec3 &v) { return out << BaseMat(v); }
 }
 
-Vec3::~Vec3() {}
-
 /*
 --------------------------------------------------------------------------------
 Vec4
 */
-Vec4::Vec4() : Vec(4, std::vector<float>{0, 0, 0, 1}) {}
-Vec4::Vec4(const Vec4 &vec) : Vec(vec.getSize(), vec.getData()) {}
-Vec4::Vec4(const Vec3 &vec3) : Vec(4, std::vector<float>{vec3.x, vec3.y, vec3.z, 1}) {}
-Vec4::Vec4(const BaseMat &mat) : Vec(4, mat.getData()) {}
-Vec4::Vec4(std::vector<float> data) : Vec(4, data) {}
-Vec4::Vec4(float _x, float _y, float _z, float _w) : Vec(4, std::vector<float>{_x, _y, _z, _w}) {}
+Vec4::Vec4() : x(0), y(0), z(0), w(1) {}
+Vec4::Vec4(const Vec3 &vec3) : x(vec3.x), y(vec3.y), z(vec3.z), w(1) {}
+Vec4::Vec4(const BaseMat &mat) : Vec4(mat.getData()) {}
+Vec4::Vec4(std::vector<float> values) {
+	if (values.size() < 4) {
+		throw std::invalid_argument("wrong vector size");
+	}
+	for (int i=0; i < 4; i++) {
+		data[i] = values[i];
+	}
+}
+Vec4::Vec4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
 
-namespace mat {
-	Vec4 operator*(const Vec4 &v, const float other) { return Vec4(BaseMat(v) * other); }
-	Vec4 operator+(const Vec4 &v, const float other) { return Vec4(BaseMat(v) + other); }
-	Vec4 operator+(const Vec4 &v, const BaseMat other) { return Vec4(BaseMat(v) + other); }
-	Vec4 operator-(const Vec4 &v, const float other) { return Vec4(BaseMat(v) - other); }
-	Vec4 operator-(const Vec4 &v, const BaseMat other) { return Vec4(BaseMat(v) - other); }
+Vec4 Vec4::normalize() const {
+	float len = x * x + y * y + z * z + w * w;
+	if (len > 0) {
+		float inv = math::invSqrt(len);
+		return Vec4(x * inv, y * inv, z * inv, w * inv);
+	}
+	return *this;
 }
 
-Vec4::~Vec4() {}
+Vec4::operator BaseMat() const { return BaseMat(4, 1, std::vector<float>(data, data + 4)); }
+
+namespace mat {
+	std::ostream &operator<<(std::ostream &out, const Vec4 &v) { return out << BaseMat(v); }
+}
 
 /*
 --------------------------------------------------------------------------------
 Mat2
 */
 Mat2::Mat2(bool identity) : SquareMat(2, identity) {}
-Mat2::Mat2(SquareMat mat) : SquareMat(mat.getSize(), mat.getData()) {}
+Mat2::Mat2(SquareMat mat) : SquareMat(std::move(mat)) {}
 Mat2::Mat2(std::vector<float> data) : SquareMat(2, data) {}
 
 namespace mat {
-	Mat2 operator*(Mat2 m, const float other) { return Mat2(BaseMat(m) * other); }
-	Mat2 operator*(Mat2 m, const BaseMat other) { return Mat2(BaseMat(m) * other); }
-	Mat2 operator+(Mat2 m, const float other) { return Mat2(BaseMat(m) + other); }
-	Mat2 operator+(Mat2 m, const BaseMat other) { return Mat2(BaseMat(m) + other); }
-	Mat2 operator-(Mat2 m, const float other) { return Mat2(BaseMat(m) - other); }
-	Mat2 operator-(Mat2 m, const BaseMat other) { return Mat2(BaseMat(m) - other); }
+	Mat2 operator*(Mat2 m, const float other) { m *= other; return m; }
+	Mat2 operator*(const Mat2 &m, const BaseMat &other) { return Mat2(SquareMat(static_cast<const BaseMat &>(m) * other)); }
+	Mat2 operator+(Mat2 m, const float other) { m += other; return m; }
+	Mat2 operator+(Mat2 m, const BaseMat &other) { m += other; return m; }
+	Mat2 operator-(Mat2 m, const float other) { m -= other; return m; }
+	Mat2 operator-(Mat2 m, const BaseMat &other) { m -= other; return m; }
 }
 
 Mat2::~Mat2() {}
@@ -109,16 +138,16 @@ Mat2::~Mat2() {}
 Mat3
 */
 Mat3::Mat3(bool identity) : SquareMat(3, identity) {}
-Mat3::Mat3(SquareMat mat) : SquareMat(mat.getSize(), mat.getData()) {}
+Mat3::Mat3(SquareMat mat) : SquareMat(std::move(mat)) {}
 Mat3::Mat3(std::vector<float> data) : SquareMat(3, data) {}
 
 namespace mat {
-	Mat3 operator*(Mat3 m, const float other) { return Mat3(BaseMat(m) * other); }
-	Mat3 operator*(Mat3 m, const BaseMat other) { return Mat3(BaseMat(m) * other); }
-	Mat3 operator+(Mat3 m, const float other) { return Mat3(BaseMat(m) + other); }
-	Mat3 operator+(Mat3 m, const BaseMat other) { return Mat3(BaseMat(m) + other); }
-	Mat3 operator-(Mat3 m, const float other) { return Mat3(BaseMat(m) - other); }
-	Mat3 operator-(Mat3 m, const BaseMat other) { return Mat3(BaseMat(m) - other); }
+	Mat3 operator*(Mat3 m, const float other) { m *= other; return m; }
+	Mat3 operator*(const Mat3 &m, const BaseMat &other) { return Mat3(SquareMat(static_cast<const BaseMat &>(m) * other)); }
+	Mat3 operator+(Mat3 m, const float other) { m += other; return m; }
+	Mat3 operator+(Mat3 m, const BaseMat &other) { m += other; return m; }
+	Mat3 operator-(Mat3 m, const float other) { m -= other; return m; }
+	Mat3 operator-(Mat3 m, const BaseMat &other) { m -= other; return m; }
 }
 
 Mat3::~Mat3() {}
@@ -127,65 +156,83 @@ Mat3::~Mat3() {}
 --------------------------------------------------------------------------------
 Mat4
 */
-Mat4::Mat4(bool identity) : SquareMat(4, identity) {}
-Mat4::Mat4(SquareMat mat) : SquareMat(mat.getSize(), mat.getData()) {}
-Mat4::Mat4(std::vector<float> data) : SquareMat(4, data) {}
+Mat4::Mat4(bool identity) {
+	for (int i=0; i < 16; i++) {
+		_data[i] = (identity && i % 5 == 0) ? 1 : 0;
+	}
+}
+Mat4::Mat4(const BaseMat &mat) {
+	if (mat.getLns() != 4 || mat.getCols() != 4) {
+		throw std::invalid_argument("wrong matrix size");
+	}
+	for (int i=0; i < 16; i++) {
+		_data[i] = mat.getData()[i];
+	}
+}
+Mat4::Mat4(std::vector<float> data) {
+	if (data.size() < 16) {
+		throw std::invalid_argument("wrong matrix size");
+	}
+	for (int i=0; i < 16; i++) {
+		_data[i] = data[i];
+	}
+}
 
-Mat4 Mat4::scale(float valX, float valY, float valZ) {
+Mat4 Mat4::scale(float valX, float valY, float valZ) const {
 	Mat4 res = *this;
 	res.get(0, 0) *= valX;
 	res.get(1, 1) *= valY;
 	res.get(2, 2) *= valZ;
 	return res;
 }
-Mat4 Mat4::scale(float val) {
+Mat4 Mat4::scale(float val) const {
 	return scale(val, val, val);
 }
-Mat4 Mat4::scale(Vec3 val) {
+Mat4 Mat4::scale(Vec3 val) const {
 	return scale(val.x, val.y, val.z);
 }
 
-Mat4 Mat4::translate(float valX, float valY, float valZ) {
+Mat4 Mat4::translate(float valX, float valY, float valZ) const {
 	Mat4 res = *this;
 	res.get(0, 3) += valX;
 	res.get(1, 3) += valY;
 	res.get(2, 3) += valZ;
 	return res;
 }
-Mat4 Mat4::translate(Vec3 val) {
+Mat4 Mat4::translate(Vec3 val) const {
 	return translate(val.x, val.y, val.z);
 }
-Mat4 Mat4::rotateRad(float radians, float axX, float axY, float axZ) {
-	Vec3 vec = Vec3(Vec3(axX, axY, axZ).normalize());
+Mat4 Mat4::rotateRad(float radians, float axX, float axY, float axZ) const {
+	Vec3 vec = Vec3(axX, axY, axZ).normalize();
 	axX = vec.x;
 	axY = vec.y;
 	axZ = vec.z;
 	Mat4 res = Mat4();
-	float cosA = std::cos(radians);
-	float sinA = std::sin(radians);
-	res.get(0, 0) = cosA + std::pow(axX, 2) * (1 - cosA);
+	float cosA = math::cos(radians);
+	float sinA = math::sin(radians);
+	res.get(0, 0) = cosA + axX * axX * (1 - cosA);
 	res.get(0, 1) = axX * axY * (1 - cosA) - axZ * sinA;
 	res.get(0, 2) = axX * axZ * (1 - cosA) + axY * sinA;
 	res.get(1, 0) = axY * axX * (1 - cosA) + axZ * sinA;
-	res.get(1, 1) = cosA + std::pow(axY, 2) * (1 - cosA);
+	res.get(1, 1) = cosA + axY * axY * (1 - cosA);
 	res.get(1, 2) = axY * axZ * (1 - cosA) - axX * sinA;
 	res.get(2, 0) = axZ * axX * (1 - cosA) - axY * sinA;
 	res.get(2, 1) = axZ * axY * (1 - cosA) + axX * sinA;
-	res.get(2, 2) = cosA + std::pow(axZ, 2) * (1 - cosA);
+	res.get(2, 2) = cosA + axZ * axZ * (1 - cosA);
 	res = *this * res;
 	return res;
 }
-Mat4 Mat4::rotateRad(float radians, Vec3 axis) {
+Mat4 Mat4::rotateRad(float radians, Vec3 axis) const {
 	return rotateRad(radians, axis.x, axis.y, axis.z);
 }
-Mat4 Mat4::rotateDeg(float degrees, float axX, float axY, float axZ) {
+Mat4 Mat4::rotateDeg(float degrees, float axX, float axY, float axZ) const {
 	return rotateRad(degrees * (M_PI / 180), axX, axY, axZ);
 }
-Mat4 Mat4::rotateDeg(float degrees, Vec3 axis) {
+Mat4 Mat4::rotateDeg(float degrees, Vec3 axis) const {
 	return rotateDeg(degrees, axis.x, axis.y, axis.z);
 }
 
-Mat4 Mat4::lookAt(const Vec3 &src, const Vec3 &dst) {
+Mat4 Mat4::lookAt(const Vec3 &src, const Vec3 &dst) const {
 	Mat4 res = Mat4();
 	Vec3 tmpUp = Vec3(0, 1, 0);
 	Vec3 fwd = normalize(dst - src);
@@ -206,7 +253,7 @@ Mat4 Mat4::lookAt(const Vec3 &src, const Vec3 &dst) {
 	res.get(2, 3) = dot(fwd, src);
 	return res;
 }
-Mat4 Mat4::perspective(float fov_y, float aspect, float z_near, float z_far) {
+Mat4 Mat4::perspective(float fov_y, float aspect, float z_near, float z_far) const {
 	Mat4 res = *this;
 
 	if (aspect == 0) {
@@ -226,16 +273,119 @@ Mat4 Mat4::perspective(float fov_y, float aspect, float z_near, float z_far) {
 	return res;
 }
 
+Mat4 Mat4::transpose() const {
+	Mat4 res(false);
+	simd::transpose(_data, res._data);
+	return res;
+}
+Mat4 Mat4::inverse() const {
+	Mat4 res(false);
+	if (!simd::inverse(_data, res._data)) {
+		throw std::invalid_argument("matrix is not invertible");
+	}
+	return res;
+}
+Mat4 Mat4::affineInverse() const {
+	Mat4 res(false);
+	if (!simd::affineInverse(_data, res._data)) {
+		throw std::invalid_argument("matrix is not invertible");
+	}
+	return res;
+}
+
+Mat4::operator BaseMat() const { return BaseMat(4, 4, std::vector<float>(_data, _data + 16)); }
+
 namespace mat {
-	Mat4 operator*(Mat4 m, const float other) { return Mat4(BaseMat(m) * other); }
-	Mat4 operator*(Mat4 m, const BaseMat other) { return Mat4(BaseMat(m) * other); }
-	Mat4 operator+(Mat4 m, const float other) { return Mat4(BaseMat(m) + other); }
-	Mat4 operator+(Mat4 m, const BaseMat other) { return Mat4(BaseMat(m) + other); }
-	Mat4 operator-(Mat4 m, const float other) { return Mat4(BaseMat(m) - other); }
-	Mat4 operator-(Mat4 m, const BaseMat other) { return Mat4(BaseMat(m) - other); }
+	std::ostream &operator<<(std::ostream &out, const Mat4 &m) { return out << BaseMat(m); }
+	Mat4 operator*(const Mat4 &m, const float other) {
+		Mat4 res = m;
+		for (int i=0; i < 16; i++) {
+			res._data[i] *= other;
+		}
+		return res;
+	}
+	Mat4 operator*(const Mat4 &m, const Mat4 &other) {
+		Mat4 res(false);
+		simd::mul(m._data, other._data, res._data);
+		return res;
+	}
+	Vec4 operator*(const Mat4 &m, const Vec4 &other) {
+		Vec4 res;
+		simd::mulVec(m._data, other.data, res.data);
+		return res;
+	}
+	Mat4 operator+(const Mat4 &m, const float other) {
+		Mat4 res = m;
+		for (int i=0; i < 16; i++) {
+			res._data[i] += other;
+		}
+		return res;
+	}
+	Mat4 operator+(const Mat4 &m, const Mat4 &other) {
+		Mat4 res = m;
+		for (int i=0; i < 16; i++) {
+			res._data[i] += other._data[i];
+		}
+		return res;
+	}
+	Mat4 operator-(const Mat4 &m, const float other) {
+		Mat4 res = m;
+		for (int i=0; i < 16; i++) {
+			res._data[i] -= other;
+		}
+		return res;
+	}
+	Mat4 operator-(const Mat4 &m, const Mat4 &other) {
+		Mat4 res = m;
+		for (int i=0; i < 16; i++) {
+			res._data[i] -= other._data[i];
+		}
+		return res;
+	}
+	bool operator==(const Mat4 &m, const Mat4 &other) {
+		for (int i=0; i < 16; i++) {
+			if (m._data[i] != other._data[i])
+				return false;
+		}
+		return true;
+	}
+}
+
+Mat4 &Mat4::operator*=(const float other) {
+	for (int i=0; i < 16; i++) {
+		_data[i] *= other;
+	}
+	return *this;
+}
+Mat4 &Mat4::operator*=(const Mat4 &other) {
+	simd::mul(_data, other._data, _data);
+	return *this;
+}
+Mat4 &Mat4::operator+=(const float other) {
+	for (int i=0; i < 16; i++) {
+		_data[i] += other;
+	}
+	return *this;
+}
+Mat4 &Mat4::operator+=(const Mat4 &other) {
+	for (int i=0; i < 16; i++) {
+		_data[i] += other._data[i];
+	}
+	return *this;
+}
+Mat4 &Mat4::operator-=(const float other) {
+	for (int i=0; i < 16; i++) {
+		_data[i] -= other;
+	}
+	return *this;
+}
+Mat4 &Mat4::operator-=(const Mat4 &other) {
+	for (int i=0; i < 16; i++) {
+		_data[i] -= other._data[i];
+	}
+	return *this;
 }
 
-Mat4::~Mat4() {}
 
 /*
 --------------------------------------------------------------------------------
@@ -251,9 +401,31 @@ r(get(0)),
 g(get((getSize() >= 2) ? 1 : 0)),
 b(get((getSize() >= 3) ? 2 : 0)) {
 }
-Vec::Vec(BaseMat mat) : Vec(mat.getLns(), mat.getData()) {}
+Vec::Vec(BaseMat mat) :
+BaseMat(std::move(mat)),
+x(get(0)),
+y(get((getSize() >= 2) ? 1 : 0)),
+z(get((getSize() >= 3) ? 2 : 0)),
+w(get((getSize() >= 4) ? 3 : 0)),
+r(get(0)),
+g(get((getSize() >= 2) ? 1 : 0)),
+b(get((getSize() >= 3) ? 2 : 0)) {
+	setCols(1);
+}
 Vec::Vec(int size, std::vector<float> data) :
-BaseMat(size, 1, data),
+BaseMat(size, 1, std::move(data)),
+x(get(0)),
+y(get((getSize() >= 2) ? 1 : 0)),
+z(get((getSize() >= 3) ? 2 : 0)),
+w(get((getSize() >= 4) ? 3 : 0)),
+r(get(0)),
+g(get((getSize() >= 2) ? 1 : 0)),
+b(get((getSize() >= 3) ? 2 : 0)) {
+}
+Vec::Vec(const Vec &v) : Vec(v.getSize(), v.getData()) {}
+// the data vector is moved so the references on its elements stay valid
+Vec::Vec(Vec &&v) :
+BaseMat(std::move(v)),
 x(get(0)),
 y(get((getSize() >= 2) ? 1 : 0)),
 z(get((getSize() >= 3) ? 2 : 0)),
@@ -269,33 +441,38 @@ float &Vec::get(int x) { return (*_data)[x]; }
 float &Vec::operator[](const int idx) { return get(idx); }
 const float &Vec::operator[](const int idx) const { return get(idx); }
 
+/*
+same size: the data is copied in place, xyzw stay bound to it
+moved-from vec (no data) or other size: new data vector, the references can only be bound again
+by building the vec again
+*/
 Vec &Vec::operator=(const Vec &other) {
 	if(&other == this)
 		return *this;
-	this->setLns(other.getLns());
+	if (_data == nullptr || getSize() != other.getSize()) {
+		this->~Vec();
+		new (this) Vec(other);
+		return *this;
+	}
 	this->setCols(other.getCols());
-	this->getData() = other.getData();
-	this->x = other.x;
-	this->y = other.y;
-	this->z = other.z;
-	this->w = other.w;
-	this->r = other.r;
-	this->g = other.g;
-	this->b = other.b;
+	this->getData() = other.getData();  // no reallocation (same size)
 	return *this;
 }
 
+Vec &Vec::operator*=(const float other) { BaseMat::operator*=(other); return *this; }
+Vec &Vec::operator+=(const float other) { BaseMat::operator+=(other); return *this; }
+Vec &Vec::operator+=(const BaseMat &other) { BaseMat::operator+=(other); return *this; }
+Vec &Vec::operator-=(const float other) { BaseMat::operator-=(other); return *this; }
+Vec &Vec::operator-=(const BaseMat &other) { BaseMat::operator-=(other); return *this; }
+
 Vec Vec::normalize() const {
-	Vec norm = Vec(getSize(), getData());
+	Vec norm = *this;
 	float len = 0;
 	for (int i=0; i < getSize(); i++) {
 		len += get(i) * get(i);
 	}
 	if (len > 0) {
-		len = std::sqrt(len);
-		for (int i=0; i < getSize(); i++) {
-			norm.get(i) /= len;
-		}
+		norm *= math::invSqrt(len);
 	}
 	return norm;
 }
@@ -313,11 +490,11 @@ float Vec::dot(const Vec &v) const
 }
 
 namespace mat {
-	Vec operator*(const Vec &v, const float other) { return Vec(BaseMat(v) * other); }
-	Vec operator+(const Vec &v, const float other) { return Vec(BaseMat(v) + other); }
-	Vec operator+(const Vec &v, const BaseMat other) { return Vec(BaseMat(v) + other); }
-	Vec operator-(const Vec &v, const float other) { return Vec(BaseMat(v) - other); }
-	Vec operator-(const Vec &v, const BaseMat other) { return Vec(BaseMat(v) - other); }
+	Vec operator*(Vec v, const float other) { v *= other; return v; }
+	Vec operator+(Vec v, const float other) { v += other; return v; }
+	Vec operator+(Vec v, const BaseMat &other) { v += other; return v; }
+	Vec operator-(Vec v, const float other) { v -= other; return v; }
+	Vec operator-(Vec v, const BaseMat &other) { v -= other; return v; }
 }
 
 Vec::~Vec() {}
@@ -333,17 +510,17 @@ SquareMat::SquareMat(int size, bool identity) : BaseMat(size) {
 		}
 	}
 }
-SquareMat::SquareMat(BaseMat mat) : BaseMat(mat.getLns(), mat.getCols(), mat.getData()) {}
+SquareMat::SquareMat(BaseMat mat) : BaseMat(std::move(mat)) {}
 SquareMat::SquareMat(int size, std::vector<float> data) : BaseMat(size, size, data) {}
 int SquareMat::getSize() const { return getLns(); }
 
 namespace mat {
-	SquareMat operator*(SquareMat m, const float other) { return SquareMat(BaseMat(m) * other); }
-	SquareMat operator*(SquareMat m, const BaseMat other) { return SquareMat(BaseMat(m) * other); }
-	SquareMat operator+(SquareMat m, const float other) { return SquareMat(BaseMat(m) + other); }
-	SquareMat operator+(SquareMat m, const BaseMat other) { return SquareMat(BaseMat(m) + other); }
-	SquareMat operator-(SquareMat m, const float other) { return SquareMat(BaseMat(m) - other); }
-	SquareMat operator-(SquareMat m, const BaseMat other) { return SquareMat(BaseMat(m) - other); }
+	SquareMat operator*(SquareMat m, const float other) { m *= other; return m; }
+	SquareMat operator*(const SquareMat &m, const BaseMat &other) { return SquareMat(static_cast<const BaseMat &>(m) * other); }
+	SquareMat operator+(SquareMat m, const float other) { m += other; return m; }
+	SquareMat operator+(SquareMat m, const BaseMat &other) { m += other; return m; }
+	SquareMat operator-(SquareMat m, const float other) { m -= other; return m; }
+	SquareMat operator-(SquareMat m, const BaseMat &other) { m -= other; return m; }
 }
 
 SquareMat::~SquareMat() {}
@@ -355,23 +532,19 @@ BaseMat
 BaseMat::BaseMat(int lns, int cols, std::vector<float> data) :
 _lns(lns),
 _cols(cols),
-_data(new std::vector<float>()) {
-	getData() = data;
+_data(new std::vector<float>(std::move(data))) {
 }
 BaseMat::BaseMat(int lns, int cols) :
 _lns(lns),
 _cols(cols),
 _data(new std::vector<float>()) {
-	for (int i = 0; i < getCols(); i++) {
-		for (int j = 0; j < getLns(); j++) {
-			getData().push_back(0);
-		}
-	}
+	getData().resize(lns * cols, 0);
 }
 BaseMat::BaseMat(int size) :
 _lns(size),
 _cols(size),
 _data(new std::vector<float>()) {
+	getData().reserve(size * size);
 	for (int i = 0; i < getCols(); i++) {
 		for (int j = 0; j < getLns(); j++) {
 			getData().push_back(((i == j) ? 1 : 0));
@@ -381,8 +554,15 @@ _data(new std::vector<float>()) {
 BaseMat::BaseMat(const BaseMat &m) :
 _lns(m.getLns()),
 _cols(m.getCols()),
-_data(new std::vector<float>()) {
-	*this = m;
+_data(new std::vector<float>(m.getData())) {
+}
+BaseMat::BaseMat(BaseMat &&m) :
+_lns(m.getLns()),
+_cols(m.getCols()),
+_data(m._data) {
+	m._lns = 0;
+	m._cols = 0;
+	m._data = nullptr;
 }
 
 void BaseMat::setLns(int lns) { _lns = lns; }
@@ -425,14 +605,8 @@ namespace mat {
 		}
 		return out;
 	}
-	BaseMat operator*(BaseMat m, const float other) {
-		BaseMat res = m;
-		for (int i=0; i < m.getLns() * m.getCols(); i++) {
-			res.getData()[i] = res.getData()[i] * other;
-		}
-		return res;
-	}
-	BaseMat operator*(BaseMat m, const BaseMat other) {
+	BaseMat operator*(BaseMat m, const float other) { m *= other; return m; }
+	BaseMat operator*(const BaseMat &m, const BaseMat &other) {
 		if (m.getCols() != other.getLns()) {
 			throw std::invalid_argument("wrong matrix size");
 		}
@@ -448,45 +622,11 @@ namespace mat {
 		}
 		return res;
 	}
-	BaseMat operator+(BaseMat m, const float other) {
-		BaseMat res = m;
-		for (int i=0; i < m.getLns() * m.getCols(); i++) {
-			res.getData()[i] = res.getData()[i] + other;
-		}
-		return res;
-	}
-	BaseMat operator+(BaseMat m, const BaseMat other) {
-		if (m.getLns() != other.getLns() || m.getCols() != other.getCols()) {
-			throw std::invalid_argument("wrong matrix size");
-		}
-		BaseMat res = m;
-		for (int ln=0; ln < res.getLns(); ln++) {
-			for (int col=0; col < res.getCols(); col++) {
-				res.get(ln, col) += other.get(ln, col);
-			}
-		}
-		return res;
-	}
-	BaseMat operator-(BaseMat m, const float other) {
-		BaseMat res = m;
-		for (int i=0; i < m.getLns() * m.getCols(); i++) {
-			res.getData()[i] = res.getData()[i] - other;
-		}
-		return res;
-	}
-	BaseMat operator-(BaseMat m, const BaseMat other) {
-		if (m.getLns() != other.getLns() || m.getCols() != other.getCols()) {
-			throw std::invalid_argument("wrong matrix size");
-		}
-		BaseMat res = m;
-		for (int ln=0; ln < res.getLns(); ln++) {
-			for (int col=0; col < res.getCols(); col++) {
-				res.get(ln, col) -= other.get(ln, col);
-			}
-		}
-		return res;
-	}
-	bool operator==(BaseMat m, const BaseMat other) {
+	BaseMat operator+(BaseMat m, const float other) { m += other; return m; }
+	BaseMat operator+(BaseMat m, const BaseMat &other) { m += other; return m; }
+	BaseMat operator-(BaseMat m, const float other) { m -= other; return m; }
+	BaseMat operator-(BaseMat m, const BaseMat &other) { m -= other; return m; }
+	bool operator==(const BaseMat &m, const BaseMat &other) {
 		if (m.getLns() != other.getLns() || m.getCols() != other.getCols()) {
 			return false;
 		}
@@ -503,9 +643,63 @@ namespace mat {
             return *this;
 		this->setLns(other.getLns());
 		this->setCols(other.getCols());
+		if (_data == nullptr)  // moved-from matrix
+			_data = new std::vector<float>();
 		this->getData() = other.getData();
         return *this;
 	}
+	BaseMat &BaseMat::operator=(BaseMat &&other) {
+		if(&other == this)
+			return *this;
+		std::swap(_lns, other._lns);
+		std::swap(_cols, other._cols);
+		std::swap(_data, other._data);
+		return *this;
+	}
+}
+
+/*
+compound operators (in place, no allocation except for the matrix product)
+*/
+BaseMat &BaseMat::operator*=(const float other) {
+	for (float &val : getData()) {
+		val *= other;
+	}
+	return *this;
+}
+BaseMat &BaseMat::operator*=(const BaseMat &other) {
+	*this = *this * other;  // the result size can be different: use the move assignment
+	return *this;
+}
+BaseMat &BaseMat::operator+=(const float other) {
+	for (float &val : getData()) {
+		val += other;
+	}
+	return *this;
+}
+BaseMat &BaseMat::operator+=(const BaseMat &other) {
+	if (getLns() != other.getLns() || getCols() != other.getCols()) {
+		throw std::invalid_argument("wrong matrix size");
+	}
+	for (int i=0; i < getLns() * getCols(); i++) {
+		getData()[i] += other.getData()[i];
+	}
+	return *this;
+}
+BaseMat &BaseMat::operator-=(const float other) {
+	for (float &val : getData()) {
+		val -= other;
+	}
+	return *this;
+}
+BaseMat &BaseMat::operator-=(const BaseMat &other) {
+	if (getLns() != other.getLns() || getCols() != other.getCols()) {
+		throw std::invalid_argument("wrong matrix size");
+	}
+	for (int i=0; i < getLns() * getCols(); i++) {
+		getData()[i] -= other.getData()[i];
+	}
+	return *this;
 }
 
 BaseMat::~BaseMat() {
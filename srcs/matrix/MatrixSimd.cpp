@@ -0,0 +1,429 @@
+#include "MatrixSimd.hpp"
+#include <cmath>
+#include <cstring>
+
+#if MAT_SIMD >= MAT_SIMD_SSE
+	#include <immintrin.h>
+#endif
+
+/*
+--------------------------------------------------------------------------------
+scalar kernels
+*/
+namespace mat {
+	namespace simd {
+		void mulScalar(const float *a, const float *b, float *out) {
+			float res[16];
+			for (int ln=0; ln < 4; ln++) {
+				for (int col=0; col < 4; col++) {
+					float r = 0;
+					for (int i=0; i < 4; i++) {
+						r += a[ln * 4 + i] * b[i * 4 + col];
+					}
+					res[ln * 4 + col] = r;
+				}
+			}
+			memcpy(out, res, sizeof(res));
+		}
+
+		void mulVecScalar(const float *m, const float *v, float *out) {
+			float res[4];
+			for (int ln=0; ln < 4; ln++) {
+				res[ln] = m[ln * 4] * v[0] + m[ln * 4 + 1] * v[1] + m[ln * 4 + 2] * v[2] + m[ln * 4 + 3] * v[3];
+			}
+			memcpy(out, res, sizeof(res));
+		}
+
+		void transposeScalar(const float *m, float *out) {
+			float res[16];
+			for (int ln=0; ln < 4; ln++) {
+				for (int col=0; col < 4; col++) {
+					res[col * 4 + ln] = m[ln * 4 + col];
+				}
+			}
+			memcpy(out, res, sizeof(res));
+		}
+
+		/*
+		cofactors method, the 2x2 determinants of the two first and two last lines
+		are computed once and reused for all the 3x3 minors
+		*/
+		bool inverseScalar(const float *m, float *out) {
+			float s0 = m[0] * m[5] - m[4] * m[1];
+			float s1 = m[0] * m[6] - m[4] * m[2];
+			float s2 = m[0] * m[7] - m[4] * m[3];
+			float s3 = m[1] * m[6] - m[5] * m[2];
+			float s4 = m[1] * m[7] - m[5] * m[3];
+			float s5 = m[2] * m[7] - m[6] * m[3];
+
+			float c5 = m[10] * m[15] - m[14] * m[11];
+			float c4 = m[9] * m[15] - m[13] * m[11];
+			float c3 = m[9] * m[14] - m[13] * m[10];
+			float c2 = m[8] * m[15] - m[12] * m[11];
+			float c1 = m[8] * m[14] - m[12] * m[10];
+			float c0 = m[8] * m[13] - m[12] * m[9];
+
+			float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+			if (det == 0) {
+				return false;
+			}
+			float invDet = 1 / det;
+
+			float res[16];
+			res[0] = ( m[5] * c5 - m[6] * c4 + m[7] * c3) * invDet;
+			res[1] = (-m[1] * c5 + m[2] * c4 - m[3] * c3) * invDet;
+			res[2] = ( m[13] * s5 - m[14] * s4 + m[15] * s3) * invDet;
+			res[3] = (-m[9] * s5 + m[10] * s4 - m[11] * s3) * invDet;
+
+			res[4] = (-m[4] * c5 + m[6] * c2 - m[7] * c1) * invDet;
+			res[5] = ( m[0] * c5 - m[2] * c2 + m[3] * c1) * invDet;
+			res[6] = (-m[12] * s5 + m[14] * s2 - m[15] * s1) * invDet;
+			res[7] = ( m[8] * s5 - m[10] * s2 + m[11] * s1) * invDet;
+
+			res[8] = ( m[4] * c4 - m[5] * c2 + m[7] * c0) * invDet;
+			res[9] = (-m[0] * c4 + m[1] * c2 - m[3] * c0) * invDet;
+			res[10] = ( m[12] * s4 - m[13] * s2 + m[15] * s0) * invDet;
+			res[11] = (-m[8] * s4 + m[9] * s2 - m[11] * s0) * invDet;
+
+			res[12] = (-m[4] * c3 + m[5] * c1 - m[6] * c0) * invDet;
+			res[13] = ( m[0] * c3 - m[1] * c1 + m[2] * c0) * invDet;
+			res[14] = (-m[12] * s3 + m[13] * s1 - m[14] * s0) * invDet;
+			res[15] = ( m[8] * s3 - m[9] * s1 + m[10] * s0) * invDet;
+			memcpy(out, res, sizeof(res));
+			return true;
+		}
+
+		/*
+		| R t |-1   | R-1  -R-1 * t |
+		| 0 1 |   = | 0     1       |
+		*/
+		bool affineInverseScalar(const float *m, float *out) {
+			// R-1 = adj(R) / det(R), computed with the cofactors of R
+			float c00 = m[5] * m[10] - m[6] * m[9];
+			float c01 = m[6] * m[8] - m[4] * m[10];
+			float c02 = m[4] * m[9] - m[5] * m[8];
+			float det = m[0] * c00 + m[1] * c01 + m[2] * c02;
+			if (det == 0) {
+				return false;
+			}
+			float invDet = 1 / det;
+
+			float res[16];
+			res[0] = c00 * invDet;
+			res[1] = (m[2] * m[9] - m[1] * m[10]) * invDet;
+			res[2] = (m[1] * m[6] - m[2] * m[5]) * invDet;
+			res[4] = c01 * invDet;
+			res[5] = (m[0] * m[10] - m[2] * m[8]) * invDet;
+			res[6] = (m[2] * m[4] - m[0] * m[6]) * invDet;
+			res[8] = c02 * invDet;
+			res[9] = (m[1] * m[8] - m[0] * m[9]) * invDet;
+			res[10] = (m[0] * m[5] - m[1] * m[4]) * invDet;
+
+			res[3] = -(res[0] * m[3] + res[1] * m[7] + res[2] * m[11]);
+			res[7] = -(res[4] * m[3] + res[5] * m[7] + res[6] * m[11]);
+			res[11] = -(res[8] * m[3] + res[9] * m[7] + res[10] * m[11]);
+
+			res[12] = 0;
+			res[13] = 0;
+			res[14] = 0;
+			res[15] = 1;
+			memcpy(out, res, sizeof(res));
+			return true;
+		}
+
+		void mulAffineScalar(const float *a, const float *b, float *out) {
+			float res[12];
+			for (int ln=0; ln < 3; ln++) {
+				for (int col=0; col < 4; col++) {
+					res[ln * 4 + col] = a[ln * 4] * b[col] + a[ln * 4 + 1] * b[4 + col] + a[ln * 4 + 2] * b[8 + col];
+				}
+				res[ln * 4 + 3] += a[ln * 4 + 3];
+			}
+			memcpy(out, res, sizeof(res));
+		}
+
+		void mulRowScalar(const float *v, const float *m, float *out) {
+			float res[4];
+			for (int col=0; col < 4; col++) {
+				res[col] = v[0] * m[col] + v[1] * m[4 + col] + v[2] * m[8 + col] + v[3] * m[12 + col];
+			}
+			memcpy(out, res, sizeof(res));
+		}
+
+		void mulRowAffineScalar(const float *v, const float *a, float *out) {
+			float res[4];
+			for (int col=0; col < 4; col++) {
+				res[col] = v[0] * a[col] + v[1] * a[4 + col] + v[2] * a[8 + col];
+			}
+			res[3] += v[3];
+			memcpy(out, res, sizeof(res));
+		}
+	}
+}
+
+/*
+--------------------------------------------------------------------------------
+simd kernels
+*/
+#if MAT_SIMD >= MAT_SIMD_SSE
+
+// _mm_shuffle_ps(a, b, SHUF(x, y, z, w)) -> a[x] a[y] b[z] b[w]
+#define SHUF(x, y, z, w) ((x) | ((y) << 2) | ((z) << 4) | ((w) << 6))
+#define SWIZZLE(v, x, y, z, w) _mm_shuffle_ps(v, v, SHUF(x, y, z, w))
+
+namespace {
+	// sum of the 4 elements, in all the lanes
+	inline __m128 hsum(__m128 v) {
+		v = _mm_add_ps(v, SWIZZLE(v, 1, 0, 3, 2));
+		return _mm_add_ps(v, SWIZZLE(v, 2, 3, 0, 1));
+	}
+
+	/*
+	2x2 matrix stored in one register: | v0 v1 |
+	                                   | v2 v3 |
+	*/
+	// a * b
+	inline __m128 mat2Mul(__m128 a, __m128 b) {
+		return _mm_add_ps(_mm_mul_ps(a, SWIZZLE(b, 0, 3, 0, 3)),
+			_mm_mul_ps(SWIZZLE(a, 1, 0, 3, 2), SWIZZLE(b, 2, 1, 2, 1)));
+	}
+	// adj(a) * b
+	inline __m128 mat2AdjMul(__m128 a, __m128 b) {
+		return _mm_sub_ps(_mm_mul_ps(SWIZZLE(a, 3, 3, 0, 0), b),
+			_mm_mul_ps(SWIZZLE(a, 1, 1, 2, 2), SWIZZLE(b, 2, 3, 0, 1)));
+	}
+	// a * adj(b)
+	inline __m128 mat2MulAdj(__m128 a, __m128 b) {
+		return _mm_sub_ps(_mm_mul_ps(a, SWIZZLE(b, 3, 0, 3, 0)),
+			_mm_mul_ps(SWIZZLE(a, 1, 0, 3, 2), SWIZZLE(b, 2, 1, 2, 1)));
+	}
+
+	// a x b (the last lane is set to 0)
+	inline __m128 cross(__m128 a, __m128 b) {
+		return _mm_sub_ps(_mm_mul_ps(SWIZZLE(a, 1, 2, 0, 3), SWIZZLE(b, 2, 0, 1, 3)),
+			_mm_mul_ps(SWIZZLE(a, 2, 0, 1, 3), SWIZZLE(b, 1, 2, 0, 3)));
+	}
+}
+
+namespace mat {
+	namespace simd {
+	#if MAT_SIMD == MAT_SIMD_AVX
+		const char *name() { return "avx"; }
+
+		// two lines of the result are computed at once
+		void mul(const float *a, const float *b, float *out) {
+			__m256 b0 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(b));
+			__m256 b1 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(b + 4));
+			__m256 b2 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(b + 8));
+			__m256 b3 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(b + 12));
+			__m256 a01 = _mm256_loadu_ps(a);
+			__m256 a23 = _mm256_loadu_ps(a + 8);
+
+			__m256 r01 = _mm256_mul_ps(_mm256_permute_ps(a01, 0x00), b0);
+			r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_permute_ps(a01, 0x55), b1));
+			r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_permute_ps(a01, 0xaa), b2));
+			r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_permute_ps(a01, 0xff), b3));
+			__m256 r23 = _mm256_mul_ps(_mm256_permute_ps(a23, 0x00), b0);
+			r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_permute_ps(a23, 0x55), b1));
+			r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_permute_ps(a23, 0xaa), b2));
+			r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_permute_ps(a23, 0xff), b3));
+
+			_mm256_storeu_ps(out, r01);
+			_mm256_storeu_ps(out + 8, r23);
+		}
+	#else
+		const char *name() { return "sse"; }
+
+		void mul(const float *a, const float *b, float *out) {
+			__m128 b0 = _mm_loadu_ps(b);
+			__m128 b1 = _mm_loadu_ps(b + 4);
+			__m128 b2 = _mm_loadu_ps(b + 8);
+			__m128 b3 = _mm_loadu_ps(b + 12);
+			__m128 res[4];
+
+			for (int ln=0; ln < 4; ln++) {
+				__m128 aLn = _mm_loadu_ps(a + ln * 4);
+				__m128 r = _mm_mul_ps(SWIZZLE(aLn, 0, 0, 0, 0), b0);
+				r = _mm_add_ps(r, _mm_mul_ps(SWIZZLE(aLn, 1, 1, 1, 1), b1));
+				r = _mm_add_ps(r, _mm_mul_ps(SWIZZLE(aLn, 2, 2, 2, 2), b2));
+				r = _mm_add_ps(r, _mm_mul_ps(SWIZZLE(aLn, 3, 3, 3, 3), b3));
+				res[ln] = r;
+			}
+			for (int ln=0; ln < 4; ln++) {
+				_mm_storeu_ps(out + ln * 4, res[ln]);
+			}
+		}
+	#endif
+
+		void mulVec(const float *m, const float *v, float *out) {
+			__m128 vec = _mm_loadu_ps(v);
+			__m128 r0 = _mm_mul_ps(_mm_loadu_ps(m), vec);
+			__m128 r1 = _mm_mul_ps(_mm_loadu_ps(m + 4), vec);
+			__m128 r2 = _mm_mul_ps(_mm_loadu_ps(m + 8), vec);
+			__m128 r3 = _mm_mul_ps(_mm_loadu_ps(m + 12), vec);
+			// after the transpose, the lane i of each register is a part of the line i dot product
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			_mm_storeu_ps(out, _mm_add_ps(_mm_add_ps(r0, r1), _mm_add_ps(r2, r3)));
+		}
+
+		void transpose(const float *m, float *out) {
+			__m128 r0 = _mm_loadu_ps(m);
+			__m128 r1 = _mm_loadu_ps(m + 4);
+			__m128 r2 = _mm_loadu_ps(m + 8);
+			__m128 r3 = _mm_loadu_ps(m + 12);
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			_mm_storeu_ps(out, r0);
+			_mm_storeu_ps(out + 4, r1);
+			_mm_storeu_ps(out + 8, r2);
+			_mm_storeu_ps(out + 12, r3);
+		}
+
+		/*
+		block method: M = | A B |  with A, B, C, D 2x2 matrix
+		                  | C D |
+		inverse(M) = 1 / det(M) * | X Y |  with X = adj(det(D) * A - B * adj(D) * C) ...
+		                          | Z W |
+		*/
+		bool inverse(const float *m, float *out) {
+			__m128 r0 = _mm_loadu_ps(m);
+			__m128 r1 = _mm_loadu_ps(m + 4);
+			__m128 r2 = _mm_loadu_ps(m + 8);
+			__m128 r3 = _mm_loadu_ps(m + 12);
+
+			__m128 a = _mm_movelh_ps(r0, r1);
+			__m128 b = _mm_movehl_ps(r1, r0);
+			__m128 c = _mm_movelh_ps(r2, r3);
+			__m128 d = _mm_movehl_ps(r3, r2);
+
+			// det(A) det(B) det(C) det(D)
+			__m128 detSub = _mm_sub_ps(
+				_mm_mul_ps(_mm_shuffle_ps(r0, r2, SHUF(0, 2, 0, 2)), _mm_shuffle_ps(r1, r3, SHUF(1, 3, 1, 3))),
+				_mm_mul_ps(_mm_shuffle_ps(r0, r2, SHUF(1, 3, 1, 3)), _mm_shuffle_ps(r1, r3, SHUF(0, 2, 0, 2))));
+			__m128 detA = SWIZZLE(detSub, 0, 0, 0, 0);
+			__m128 detB = SWIZZLE(detSub, 1, 1, 1, 1);
+			__m128 detC = SWIZZLE(detSub, 2, 2, 2, 2);
+			__m128 detD = SWIZZLE(detSub, 3, 3, 3, 3);
+
+			__m128 dC = mat2AdjMul(d, c);
+			__m128 aB = mat2AdjMul(a, b);
+			__m128 x = _mm_sub_ps(_mm_mul_ps(detD, a), mat2Mul(b, dC));
+			__m128 w = _mm_sub_ps(_mm_mul_ps(detA, d), mat2Mul(c, aB));
+			__m128 y = _mm_sub_ps(_mm_mul_ps(detB, c), mat2MulAdj(d, aB));
+			__m128 z = _mm_sub_ps(_mm_mul_ps(detC, b), mat2MulAdj(a, dC));
+
+			// det(M) = det(A) * det(D) + det(B) * det(C) - trace(adj(A) * B * adj(D) * C)
+			__m128 detM = _mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC));
+			detM = _mm_sub_ps(detM, hsum(_mm_mul_ps(aB, SWIZZLE(dC, 0, 2, 1, 3))));
+			if (_mm_cvtss_f32(detM) == 0) {
+				return false;
+			}
+
+			__m128 rDetM = _mm_div_ps(_mm_setr_ps(1.f, -1.f, -1.f, 1.f), detM);
+			x = _mm_mul_ps(x, rDetM);
+			y = _mm_mul_ps(y, rDetM);
+			z = _mm_mul_ps(z, rDetM);
+			w = _mm_mul_ps(w, rDetM);
+
+			// adjugate of each block and store
+			_mm_storeu_ps(out, _mm_shuffle_ps(x, y, SHUF(3, 1, 3, 1)));
+			_mm_storeu_ps(out + 4, _mm_shuffle_ps(x, y, SHUF(2, 0, 2, 0)));
+			_mm_storeu_ps(out + 8, _mm_shuffle_ps(z, w, SHUF(3, 1, 3, 1)));
+			_mm_storeu_ps(out + 12, _mm_shuffle_ps(z, w, SHUF(2, 0, 2, 0)));
+			return true;
+		}
+
+		/*
+		the columns of R-1 are the cross products of the lines of R divided by det(R)
+		*/
+		bool affineInverse(const float *m, float *out) {
+			__m128 r0 = _mm_loadu_ps(m);
+			__m128 r1 = _mm_loadu_ps(m + 4);
+			__m128 r2 = _mm_loadu_ps(m + 8);
+
+			__m128 c0 = cross(r1, r2);
+			__m128 c1 = cross(r2, r0);
+			__m128 c2 = cross(r0, r1);
+			__m128 det = hsum(_mm_mul_ps(r0, c0));  // c0 last lane is 0
+			if (_mm_cvtss_f32(det) == 0) {
+				return false;
+			}
+			__m128 rDet = _mm_div_ps(_mm_set1_ps(1.f), det);
+			c0 = _mm_mul_ps(c0, rDet);
+			c1 = _mm_mul_ps(c1, rDet);
+			c2 = _mm_mul_ps(c2, rDet);
+
+			// -R-1 * t, with t the last column of m
+			__m128 t = _mm_mul_ps(c0, SWIZZLE(r0, 3, 3, 3, 3));
+			t = _mm_add_ps(t, _mm_mul_ps(c1, SWIZZLE(r1, 3, 3, 3, 3)));
+			t = _mm_add_ps(t, _mm_mul_ps(c2, SWIZZLE(r2, 3, 3, 3, 3)));
+			__m128 c3 = _mm_sub_ps(_mm_setr_ps(0, 0, 0, 1), t);
+
+			_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+			_mm_storeu_ps(out, c0);
+			_mm_storeu_ps(out + 4, c1);
+			_mm_storeu_ps(out + 8, c2);
+			_mm_storeu_ps(out + 12, c3);
+			return true;
+		}
+
+		void mulAffine(const float *a, const float *b, float *out) {
+			__m128 b0 = _mm_loadu_ps(b);
+			__m128 b1 = _mm_loadu_ps(b + 4);
+			__m128 b2 = _mm_loadu_ps(b + 8);
+			// a translation is only added to the last column
+			__m128 mask = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+			__m128 res[3];
+
+			for (int ln=0; ln < 3; ln++) {
+				__m128 aLn = _mm_loadu_ps(a + ln * 4);
+				__m128 r = _mm_mul_ps(SWIZZLE(aLn, 0, 0, 0, 0), b0);
+				r = _mm_add_ps(r, _mm_mul_ps(SWIZZLE(aLn, 1, 1, 1, 1), b1));
+				r = _mm_add_ps(r, _mm_mul_ps(SWIZZLE(aLn, 2, 2, 2, 2), b2));
+				res[ln] = _mm_add_ps(r, _mm_and_ps(aLn, mask));
+			}
+			for (int ln=0; ln < 3; ln++) {
+				_mm_storeu_ps(out + ln * 4, res[ln]);
+			}
+		}
+
+		void mulRow(const float *v, const float *m, float *out) {
+			__m128 vec = _mm_loadu_ps(v);
+			__m128 r = _mm_mul_ps(SWIZZLE(vec, 0, 0, 0, 0), _mm_loadu_ps(m));
+			r = _mm_add_ps(r, _mm_mul_ps(SWIZZLE(vec, 1, 1, 1, 1), _mm_loadu_ps(m + 4)));
+			r = _mm_add_ps(r, _mm_mul_ps(SWIZZLE(vec, 2, 2, 2, 2), _mm_loadu_ps(m + 8)));
+			r = _mm_add_ps(r, _mm_mul_ps(SWIZZLE(vec, 3, 3, 3, 3), _mm_loadu_ps(m + 12)));
+			_mm_storeu_ps(out, r);
+		}
+
+		void mulRowAffine(const float *v, const float *a, float *out) {
+			__m128 vec = _mm_loadu_ps(v);
+			__m128 mask = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+			__m128 r = _mm_mul_ps(SWIZZLE(vec, 0, 0, 0, 0), _mm_loadu_ps(a));
+			r = _mm_add_ps(r, _mm_mul_ps(SWIZZLE(vec, 1, 1, 1, 1), _mm_loadu_ps(a + 4)));
+			r = _mm_add_ps(r, _mm_mul_ps(SWIZZLE(vec, 2, 2, 2, 2), _mm_loadu_ps(a + 8)));
+			_mm_storeu_ps(out, _mm_add_ps(r, _mm_and_ps(vec, mask)));  // implicit 0 0 0 1 last line
+		}
+	}
+}
+
+#undef SHUF
+#undef SWIZZLE
+
+#else
+
+namespace mat {
+	namespace simd {
+		const char *name() { return "scalar"; }
+
+		void mul(const float *a, const float *b, float *out) { mulScalar(a, b, out); }
+		void mulVec(const float *m, const float *v, float *out) { mulVecScalar(m, v, out); }
+		void transpose(const float *m, float *out) { transposeScalar(m, out); }
+		bool inverse(const float *m, float *out) { return inverseScalar(m, out); }
+		bool affineInverse(const float *m, float *out) { return affineInverseScalar(m, out); }
+		void mulAffine(const float *a, const float *b, float *out) { mulAffineScalar(a, b, out); }
+		void mulRow(const float *v, const float *m, float *out) { mulRowScalar(v, m, out); }
+		void mulRowAffine(const float *v, const float *a, float *out) { mulRowAffineScalar(v, a, out); }
+	}
+}
+
+#endif
@@ -1,16 +1,53 @@
 #include "Quaternion.hpp"
+#include "MatrixSimd.hpp"
+#include "FastMath.hpp"
 
 #include <cmath>
 
+#if MAT_SIMD >= MAT_SIMD_SSE
+	#include <immintrin.h>
+#endif
+
 using namespace mat;
 
+namespace {
+	/*
+	when the quaternions are closer than this (1 - dot), the slerp is replaced by a nlerp
+	max error on the rotation: 9e-8 rad with 0.0001, 3e-5 rad with 0.005 (keys up to 11 degrees apart)
+	*/
+#if MAT_FAST_MATH
+	const float NLERP_LIMIT = 0.005f;
+#else
+	const float NLERP_LIMIT = 0.0001f;
+#endif
+
+	/*
+	slerp coefficients for one quaternion: res = sclp * from + sclq * to
+	dotProduct is already positive (to has been flipped if needed)
+	return true if the coefficients are the nlerp ones (the result must be normalized)
+	*/
+	inline bool slerpCoefs(float dotProduct, float step, float &sclp, float &sclq) {
+		if((1.0f - dotProduct) > NLERP_LIMIT) {
+			float omega = math::acos(dotProduct);
+			float sinom = math::sin(omega);
+			sclp = math::sin((1.0f - step) * omega) / sinom;
+			sclq = math::sin(step * omega) / sinom;
+			return false;
+		}
+		sclp = 1.0f - step;
+		sclq = step;
+		return true;
+	}
+}
+
 Quaternion::Quaternion(float degrees, const Vec3 &v) :
 vec(Vec3()) {
 	float rad = degrees / 360 * (float)M_PI * 2;
-	vec = v * sin(rad/2);
-	w = std::cos(rad/2);
+	vec = v * math::sin(rad/2);
+	w = math::cos(rad/2);
 }
-Quaternion::Quaternion() : Quaternion(1, Vec3(0, 0, 0)) {}
+Quaternion::Quaternion() : vec(Vec3(0, 0, 0)), w(1) {}
+Quaternion::Quaternion(float w_, float x, float y, float z) : vec(Vec3(x, y, z)), w(w_) {}
 
 const Quaternion Quaternion::inverted() const {
 	Quaternion ret;
@@ -82,38 +119,35 @@ const Quaternion Quaternion::slerp(const Quaternion &to, float step) const
 	// Calculate coefficients
 	float sclp;
 	float sclq;
-	if((1.0f - dotProduct) > 0.0001f) {
-		float omega;
-		float sinom;
-		omega = acos(dotProduct); // extract theta from dot product cos theta
-		sinom = sin(omega);
-		sclp  = sin((1.0f - step) * omega) / sinom;
-		sclq  = sin(step * omega) / sinom;
-	}
-	else {
-		// if dot product is very close to 0
-		sclp = 1.0f - step;
-		sclq = step;
-	}
+	bool isNlerp = slerpCoefs(dotProduct, step, sclp, sclq);
 
 	res.vec.x = sclp * vec.x + sclq * end.vec.x;
 	res.vec.y = sclp * vec.y + sclq * end.vec.y;
 	res.vec.z = sclp * vec.z + sclq * end.vec.z;
 	res.w = sclp * w + sclq * end.w;
 
-	return res;
+	return isNlerp ? res.normalize() : res;
 }
 
-const Quaternion Quaternion::normalize() const {
-	Quaternion ret = Quaternion();
-	float det = std::sqrt(w*w + vec.x*vec.x + vec.y*vec.y + vec.z*vec.z);
+/*
+linear interpolation then normalization, no trigonometry
+the speed is not constant but it's really close to slerp with small angles (between 2 keyframes)
+*/
+const Quaternion Quaternion::nlerp(const Quaternion &to, float step) const
+{
+	float dotProduct = this->vec.x * to.vec.x + this->vec.y * to.vec.y + this->vec.z * to.vec.z + this->w * to.w;
+	// take the shortest path
+	float sclq = (dotProduct < 0.0f) ? -step : step;
+	float sclp = 1.0f - step;
 
-	ret.w = w / det;
-	ret.vec.x = vec.x / det;
-	ret.vec.y = vec.y / det;
-	ret.vec.z = vec.z / det;
+	return Quaternion(sclp * w + sclq * to.w, sclp * vec.x + sclq * to.vec.x,
+		sclp * vec.y + sclq * to.vec.y, sclp * vec.z + sclq * to.vec.z).normalize();
+}
 
-	return ret;
+const Quaternion Quaternion::normalize() const {
+	float invDet = math::invSqrt(w*w + vec.x*vec.x + vec.y*vec.y + vec.z*vec.z);
+
+	return Quaternion(w * invDet, vec.x * invDet, vec.y * invDet, vec.z * invDet);
 }
 
 void Quaternion::toAxisAngle(float &flAngle, Vec3 &vecAxis) const
@@ -136,13 +170,29 @@ void Quaternion::toAxisAngle(float &flAngle, Vec3 &vecAxis) const
 	flAngle *= 360 / ((float)M_PI * 2);
 }
 
+/*
+closed form of the rotation matrix
+with s = 2 / |q|^2 the result is a pure rotation even if q is not normalized
+*/
 Mat4 Quaternion::toMatrix() const {
 	Mat4 res = Mat4();  // identity
-	float angle;
-	Vec3 vec;
+	float n = w * w + vec.x * vec.x + vec.y * vec.y + vec.z * vec.z;
+	float s = (n > 0) ? 2 / n : 0;
+
+	float xs = vec.x * s, ys = vec.y * s, zs = vec.z * s;
+	float wx = w * xs, wy = w * ys, wz = w * zs;
+	float xx = vec.x * xs, xy = vec.x * ys, xz = vec.x * zs;
+	float yy = vec.y * ys, yz = vec.y * zs, zz = vec.z * zs;
 
-	toAxisAngle(angle, vec);
-	res = res.rotateDeg(angle, vec);
+	res.get(0, 0) = 1 - (yy + zz);
+	res.get(0, 1) = xy - wz;
+	res.get(0, 2) = xz + wy;
+	res.get(1, 0) = xy + wz;
+	res.get(1, 1) = 1 - (xx + zz);
+	res.get(1, 2) = yz - wx;
+	res.get(2, 0) = xz - wy;
+	res.get(2, 1) = yz + wx;
+	res.get(2, 2) = 1 - (xx + yy);
 	return res;
 }
 
@@ -152,4 +202,190 @@ namespace mat {
 		return out;
 	}
 	const Quaternion slerp(const Quaternion &from, const Quaternion &to, float step) { return from.slerp(to, step); }
+	const Quaternion nlerp(const Quaternion &from, const Quaternion &to, float step) { return from.nlerp(to, step); }
+}
+
+/*
+--------------------------------------------------------------------------------
+batch (SoA) functions
+*/
+namespace {
+	inline void normalizeOne(const mat::QuaternionSoA &q, const mat::QuaternionSoA &out, int i) {
+		float invDet = math::invSqrt(q.w[i] * q.w[i] + q.x[i] * q.x[i] + q.y[i] * q.y[i] + q.z[i] * q.z[i]);
+		out.x[i] = q.x[i] * invDet;
+		out.y[i] = q.y[i] * invDet;
+		out.z[i] = q.z[i] * invDet;
+		out.w[i] = q.w[i] * invDet;
+	}
+
+	inline void mulOne(const mat::QuaternionSoA &a, const mat::QuaternionSoA &b, const mat::QuaternionSoA &out, \
+	int i) {
+		float w = a.w[i] * b.w[i] - a.x[i] * b.x[i] - a.y[i] * b.y[i] - a.z[i] * b.z[i];
+		float x = a.w[i] * b.x[i] + a.x[i] * b.w[i] + a.y[i] * b.z[i] - a.z[i] * b.y[i];
+		float y = a.w[i] * b.y[i] + a.y[i] * b.w[i] + a.z[i] * b.x[i] - a.x[i] * b.z[i];
+		float z = a.w[i] * b.z[i] + a.z[i] * b.w[i] + a.x[i] * b.y[i] - a.y[i] * b.x[i];
+		out.x[i] = x;
+		out.y[i] = y;
+		out.z[i] = z;
+		out.w[i] = w;
+	}
+
+	inline void interpolateOne(const mat::QuaternionSoA &from, const mat::QuaternionSoA &to, \
+	const float *steps, const mat::QuaternionSoA &out, int i, bool isSlerp) {
+		float dotProduct = from.x[i] * to.x[i] + from.y[i] * to.y[i] + from.z[i] * to.z[i] + from.w[i] * to.w[i];
+		float sign = (dotProduct < 0.0f) ? -1.0f : 1.0f;
+		float sclp = 1.0f - steps[i];
+		float sclq = steps[i];
+		bool isNlerp = !isSlerp;
+		if (isSlerp) {
+			isNlerp = slerpCoefs(dotProduct * sign, steps[i], sclp, sclq);
+		}
+		sclq *= sign;
+		out.x[i] = sclp * from.x[i] + sclq * to.x[i];
+		out.y[i] = sclp * from.y[i] + sclq * to.y[i];
+		out.z[i] = sclp * from.z[i] + sclq * to.z[i];
+		out.w[i] = sclp * from.w[i] + sclq * to.w[i];
+		if (isNlerp) {
+			normalizeOne(out, out, i);
+		}
+	}
+
+#if MAT_SIMD >= MAT_SIMD_SSE
+	// 1 / |q| for 4 quaternions
+	inline __m128 invLength(__m128 x, __m128 y, __m128 z, __m128 w) {
+		__m128 n = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)),
+			_mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w)));
+	#if MAT_FAST_MATH
+		// hardware estimation + 1 newton step
+		__m128 est = _mm_rsqrt_ps(n);
+		__m128 half = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), n), _mm_mul_ps(est, est));
+		return _mm_mul_ps(est, _mm_sub_ps(_mm_set1_ps(1.5f), half));
+	#else
+		return _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(n));
+	#endif
+	}
+
+	/*
+	interpolate 4 quaternions at once
+	for the slerp, the coefficients need sin / acos so they are computed lane by lane
+	*/
+	inline void interpolate4(const mat::QuaternionSoA &from, const mat::QuaternionSoA &to, \
+	const float *steps, const mat::QuaternionSoA &out, int i, bool isSlerp) {
+		__m128 fx = _mm_loadu_ps(from.x + i), fy = _mm_loadu_ps(from.y + i);
+		__m128 fz = _mm_loadu_ps(from.z + i), fw = _mm_loadu_ps(from.w + i);
+		__m128 tx = _mm_loadu_ps(to.x + i), ty = _mm_loadu_ps(to.y + i);
+		__m128 tz = _mm_loadu_ps(to.z + i), tw = _mm_loadu_ps(to.w + i);
+		__m128 step = _mm_loadu_ps(steps + i);
+
+		__m128 dotProduct = _mm_add_ps(_mm_add_ps(_mm_mul_ps(fx, tx), _mm_mul_ps(fy, ty)),
+			_mm_add_ps(_mm_mul_ps(fz, tz), _mm_mul_ps(fw, tw)));
+		// sign bit of the dot product, used to take the shortest path
+		__m128 sign = _mm_and_ps(dotProduct, _mm_set1_ps(-0.0f));
+
+		__m128 sclp;
+		__m128 sclq;
+		bool isNlerp = !isSlerp;
+		if (isSlerp) {
+			alignas(16) float d[4], t[4], p[4], q[4];
+			_mm_store_ps(d, _mm_xor_ps(dotProduct, sign));
+			_mm_store_ps(t, step);
+			for (int j=0; j < 4; j++) {
+				// if one lane is a nlerp, the 4 are normalized (no effect on the slerp ones)
+				isNlerp |= slerpCoefs(d[j], t[j], p[j], q[j]);
+			}
+			sclp = _mm_load_ps(p);
+			sclq = _mm_load_ps(q);
+		}
+		else {
+			sclp = _mm_sub_ps(_mm_set1_ps(1.0f), step);
+			sclq = step;
+		}
+		sclq = _mm_xor_ps(sclq, sign);
+
+		__m128 x = _mm_add_ps(_mm_mul_ps(sclp, fx), _mm_mul_ps(sclq, tx));
+		__m128 y = _mm_add_ps(_mm_mul_ps(sclp, fy), _mm_mul_ps(sclq, ty));
+		__m128 z = _mm_add_ps(_mm_mul_ps(sclp, fz), _mm_mul_ps(sclq, tz));
+		__m128 w = _mm_add_ps(_mm_mul_ps(sclp, fw), _mm_mul_ps(sclq, tw));
+		if (isNlerp) {
+			__m128 inv = invLength(x, y, z, w);
+			x = _mm_mul_ps(x, inv);
+			y = _mm_mul_ps(y, inv);
+			z = _mm_mul_ps(z, inv);
+			w = _mm_mul_ps(w, inv);
+		}
+		_mm_storeu_ps(out.x + i, x);
+		_mm_storeu_ps(out.y + i, y);
+		_mm_storeu_ps(out.z + i, z);
+		_mm_storeu_ps(out.w + i, w);
+	}
+#endif
+
+	void interpolateBatch(const mat::QuaternionSoA &from, const mat::QuaternionSoA &to, \
+	const float *steps, const mat::QuaternionSoA &out, int count, bool isSlerp) {
+		int i = 0;
+	#if MAT_SIMD >= MAT_SIMD_SSE
+		for (; i + 4 <= count; i += 4) {
+			interpolate4(from, to, steps, out, i, isSlerp);
+		}
+	#endif
+		for (; i < count; i++) {
+			interpolateOne(from, to, steps, out, i, isSlerp);
+		}
+	}
+}
+
+namespace mat {
+	void normalizeBatch(const QuaternionSoA &q, const QuaternionSoA &out, int count) {
+		int i = 0;
+	#if MAT_SIMD >= MAT_SIMD_SSE
+		for (; i + 4 <= count; i += 4) {
+			__m128 x = _mm_loadu_ps(q.x + i);
+			__m128 y = _mm_loadu_ps(q.y + i);
+			__m128 z = _mm_loadu_ps(q.z + i);
+			__m128 w = _mm_loadu_ps(q.w + i);
+			__m128 inv = invLength(x, y, z, w);
+			_mm_storeu_ps(out.x + i, _mm_mul_ps(x, inv));
+			_mm_storeu_ps(out.y + i, _mm_mul_ps(y, inv));
+			_mm_storeu_ps(out.z + i, _mm_mul_ps(z, inv));
+			_mm_storeu_ps(out.w + i, _mm_mul_ps(w, inv));
+		}
+	#endif
+		for (; i < count; i++) {
+			normalizeOne(q, out, i);
+		}
+	}
+	void mulBatch(const QuaternionSoA &a, const QuaternionSoA &b, const QuaternionSoA &out, int count) {
+		int i = 0;
+	#if MAT_SIMD >= MAT_SIMD_SSE
+		for (; i + 4 <= count; i += 4) {
+			__m128 aw = _mm_loadu_ps(a.w + i), ax = _mm_loadu_ps(a.x + i);
+			__m128 ay = _mm_loadu_ps(a.y + i), az = _mm_loadu_ps(a.z + i);
+			__m128 bw = _mm_loadu_ps(b.w + i), bx = _mm_loadu_ps(b.x + i);
+			__m128 by = _mm_loadu_ps(b.y + i), bz = _mm_loadu_ps(b.z + i);
+			__m128 w = _mm_sub_ps(_mm_sub_ps(_mm_mul_ps(aw, bw), _mm_mul_ps(ax, bx)),
+				_mm_add_ps(_mm_mul_ps(ay, by), _mm_mul_ps(az, bz)));
+			__m128 x = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(aw, bx), _mm_mul_ps(ax, bw)), _mm_mul_ps(ay, bz)),
+				_mm_mul_ps(az, by));
+			__m128 y = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(aw, by), _mm_mul_ps(ay, bw)), _mm_mul_ps(az, bx)),
+				_mm_mul_ps(ax, bz));
+			__m128 z = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(aw, bz), _mm_mul_ps(az, bw)), _mm_mul_ps(ax, by)),
+				_mm_mul_ps(ay, bx));
+			_mm_storeu_ps(out.x + i, x);
+			_mm_storeu_ps(out.y + i, y);
+			_mm_storeu_ps(out.z + i, z);
+			_mm_storeu_ps(out.w + i, w);
+		}
+	#endif
+		for (; i < count; i++) {
+			mulOne(a, b, out, i);
+		}
+	}
+	void nlerpBatch(const QuaternionSoA &from, const QuaternionSoA &to, const float *steps, \
+	const QuaternionSoA &out, int count) {
+		interpolateBatch(from, to, steps, out, count, false);
+	}
+	void slerpBatch(const QuaternionSoA &from, const QuaternionSoA &to, const float *steps, \
+	const QuaternionSoA &out, int count) {
+		interpolateBatch(from, to, steps, out, count, true);
+	}
 }
@@ -0,0 +1,307 @@
+#include "Vec3Array.hpp"
+#include "MatrixSimd.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <utility>
+
+#if MAT_SIMD >= MAT_SIMD_SSE
+	#include <immintrin.h>
+#endif
+
+using namespace mat;
+
+namespace {
+	float *allocSpans(int capacity) {
+		if (capacity == 0)
+			return nullptr;
+		void *ptr = nullptr;
+		if (posix_memalign(&ptr, 32, 3 * capacity * sizeof(float)) != 0) {
+			throw std::bad_alloc();
+		}
+		return static_cast<float*>(ptr);
+	}
+	int roundCapacity(int size) { return (size + 7) & ~7; }
+
+	/*
+	one simd register of float: the kernels are written once for sse and avx
+	*/
+#if MAT_SIMD == MAT_SIMD_AVX
+	typedef __m256 Pack;
+	const int PACK_SIZE = 8;
+	inline Pack load(const float *p) { return _mm256_load_ps(p); }
+	inline Pack loadu(const float *p) { return _mm256_loadu_ps(p); }
+	inline void store(float *p, Pack v) { _mm256_store_ps(p, v); }
+	inline void storeu(float *p, Pack v) { _mm256_storeu_ps(p, v); }
+	inline Pack set1(float f) { return _mm256_set1_ps(f); }
+	inline Pack add(Pack a, Pack b) { return _mm256_add_ps(a, b); }
+	inline Pack sub(Pack a, Pack b) { return _mm256_sub_ps(a, b); }
+	inline Pack mul(Pack a, Pack b) { return _mm256_mul_ps(a, b); }
+	inline Pack min(Pack a, Pack b) { return _mm256_min_ps(a, b); }
+	inline Pack max(Pack a, Pack b) { return _mm256_max_ps(a, b); }
+#elif MAT_SIMD == MAT_SIMD_SSE
+	typedef __m128 Pack;
+	const int PACK_SIZE = 4;
+	inline Pack load(const float *p) { return _mm_load_ps(p); }
+	inline Pack loadu(const float *p) { return _mm_loadu_ps(p); }
+	inline void store(float *p, Pack v) { _mm_store_ps(p, v); }
+	inline void storeu(float *p, Pack v) { _mm_storeu_ps(p, v); }
+	inline Pack set1(float f) { return _mm_set1_ps(f); }
+	inline Pack add(Pack a, Pack b) { return _mm_add_ps(a, b); }
+	inline Pack sub(Pack a, Pack b) { return _mm_sub_ps(a, b); }
+	inline Pack mul(Pack a, Pack b) { return _mm_mul_ps(a, b); }
+	inline Pack min(Pack a, Pack b) { return _mm_min_ps(a, b); }
+	inline Pack max(Pack a, Pack b) { return _mm_max_ps(a, b); }
+#endif
+
+	/*
+	m is a row major matrix, only the 3 first lines are used
+	w is 1 for a point and 0 for a normal (no translation)
+	*/
+	void transform(const float *m, float w, const Vec3Array &in, Vec3Array &out) {
+		out.resize(in.getSize());
+		const float *x = in.getX();
+		const float *y = in.getY();
+		const float *z = in.getZ();
+		float *ox = out.getX();
+		float *oy = out.getY();
+		float *oz = out.getZ();
+		int i = 0;
+	#if MAT_SIMD >= MAT_SIMD_SSE
+		Pack m0 = set1(m[0]), m1 = set1(m[1]), m2 = set1(m[2]), m3 = set1(m[3] * w);
+		Pack m4 = set1(m[4]), m5 = set1(m[5]), m6 = set1(m[6]), m7 = set1(m[7] * w);
+		Pack m8 = set1(m[8]), m9 = set1(m[9]), m10 = set1(m[10]), m11 = set1(m[11] * w);
+		for (; i + PACK_SIZE <= in.getSize(); i += PACK_SIZE) {
+			Pack px = load(x + i);
+			Pack py = load(y + i);
+			Pack pz = load(z + i);
+			store(ox + i, add(add(mul(m0, px), mul(m1, py)), add(mul(m2, pz), m3)));
+			store(oy + i, add(add(mul(m4, px), mul(m5, py)), add(mul(m6, pz), m7)));
+			store(oz + i, add(add(mul(m8, px), mul(m9, py)), add(mul(m10, pz), m11)));
+		}
+	#endif
+		for (; i < in.getSize(); i++) {
+			float px = x[i];
+			float py = y[i];
+			float pz = z[i];
+			ox[i] = m[0] * px + m[1] * py + m[2] * pz + m[3] * w;
+			oy[i] = m[4] * px + m[5] * py + m[6] * pz + m[7] * w;
+			oz[i] = m[8] * px + m[9] * py + m[10] * pz + m[11] * w;
+		}
+	}
+}
+
+/*
+--------------------------------------------------------------------------------
+Vec3Array
+*/
+Vec3Array::Vec3Array() : _size(0), _capacity(0), _data(nullptr) {}
+Vec3Array::Vec3Array(int size) : _size(0), _capacity(0), _data(nullptr) {
+	resize(size);
+}
+Vec3Array::Vec3Array(const Vec3Array &other) :
+_size(other._size),
+_capacity(roundCapacity(other._size)),
+_data(allocSpans(_capacity)) {
+	for (int span=0; span < 3 && _size > 0; span++) {
+		memcpy(_data + span * _capacity, other._data + span * other._capacity, _size * sizeof(float));
+	}
+}
+Vec3Array::Vec3Array(Vec3Array &&other) :
+_size(other._size),
+_capacity(other._capacity),
+_data(other._data) {
+	other._size = 0;
+	other._capacity = 0;
+	other._data = nullptr;
+}
+
+Vec3Array::~Vec3Array() {
+	free(_data);
+}
+
+void Vec3Array::resize(int size) {
+	if (size > _capacity) {
+		int capacity = roundCapacity(std::max(size, 2 * _capacity));
+		float *data = allocSpans(capacity);
+		for (int span=0; span < 3 && _size > 0; span++) {
+			memcpy(data + span * capacity, _data + span * _capacity, _size * sizeof(float));
+		}
+		free(_data);
+		_data = data;
+		_capacity = capacity;
+	}
+	for (int span=0; span < 3 && size > _size; span++) {
+		memset(_data + span * _capacity + _size, 0, (size - _size) * sizeof(float));
+	}
+	_size = size;
+}
+
+void Vec3Array::load(const float *data, int count, int stride) {
+	resize(count);
+	float *x = getX();
+	float *y = getY();
+	float *z = getZ();
+	for (int i=0; i < count; i++) {
+		x[i] = data[i * stride];
+		y[i] = data[i * stride + 1];
+		z[i] = data[i * stride + 2];
+	}
+}
+
+void Vec3Array::set(int idx, const Vec3 &v) {
+	getX()[idx] = v.x;
+	getY()[idx] = v.y;
+	getZ()[idx] = v.z;
+}
+
+Vec3Array &Vec3Array::operator=(const Vec3Array &other) {
+	if (&other == this)
+		return *this;
+	resize(other._size);
+	for (int span=0; span < 3 && _size > 0; span++) {
+		memcpy(_data + span * _capacity, other._data + span * other._capacity, _size * sizeof(float));
+	}
+	return *this;
+}
+Vec3Array &Vec3Array::operator=(Vec3Array &&other) {
+	if (&other == this)
+		return *this;
+	std::swap(_size, other._size);
+	std::swap(_capacity, other._capacity);
+	std::swap(_data, other._data);
+	return *this;
+}
+
+/*
+--------------------------------------------------------------------------------
+batch operations
+*/
+namespace mat {
+	void transformPoints(const Mat4 &m, const Vec3Array &in, Vec3Array &out) { transform(m.getData(), 1, in, out); }
+	void transformPoints(const Affine &m, const Vec3Array &in, Vec3Array &out) { transform(m.getData(), 1, in, out); }
+	void transformNormals(const Mat4 &m, const Vec3Array &in, Vec3Array &out) { transform(m.getData(), 0, in, out); }
+	void transformNormals(const Affine &m, const Vec3Array &in, Vec3Array &out) { transform(m.getData(), 0, in, out); }
+
+	void bounds(const Vec3Array &in, Vec3 &min, Vec3 &max) {
+		const float *x = in.getX();
+		const float *y = in.getY();
+		const float *z = in.getZ();
+		// an empty array gives an "inverted" box: it can be merged with another box without changing it
+		min = Vec3(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), \
+			std::numeric_limits<float>::max());
+		max = Vec3(std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), \
+			std::numeric_limits<float>::lowest());
+		int i = 0;
+	#if MAT_SIMD >= MAT_SIMD_SSE
+		if (in.getSize() >= PACK_SIZE) {
+			Pack minX = load(x), minY = load(y), minZ = load(z);
+			Pack maxX = minX, maxY = minY, maxZ = minZ;
+			for (i = PACK_SIZE; i + PACK_SIZE <= in.getSize(); i += PACK_SIZE) {
+				Pack px = load(x + i);
+				Pack py = load(y + i);
+				Pack pz = load(z + i);
+				minX = ::min(minX, px);
+				minY = ::min(minY, py);
+				minZ = ::min(minZ, pz);
+				maxX = ::max(maxX, px);
+				maxY = ::max(maxY, py);
+				maxZ = ::max(maxZ, pz);
+			}
+			alignas(32) float lanes[6][PACK_SIZE];
+			store(lanes[0], minX);
+			store(lanes[1], minY);
+			store(lanes[2], minZ);
+			store(lanes[3], maxX);
+			store(lanes[4], maxY);
+			store(lanes[5], maxZ);
+			for (int lane=0; lane < PACK_SIZE; lane++) {
+				for (int axis=0; axis < 3; axis++) {
+					min[axis] = std::min(min[axis], lanes[axis][lane]);
+					max[axis] = std::max(max[axis], lanes[3 + axis][lane]);
+				}
+			}
+		}
+	#endif
+		for (; i < in.getSize(); i++) {
+			min.x = std::min(min.x, x[i]);
+			min.y = std::min(min.y, y[i]);
+			min.z = std::min(min.z, z[i]);
+			max.x = std::max(max.x, x[i]);
+			max.y = std::max(max.y, y[i]);
+			max.z = std::max(max.z, z[i]);
+		}
+	}
+
+	void dot(const Vec3Array &a, const Vec3Array &b, float *out) {
+		if (a.getSize() != b.getSize()) {
+			throw std::invalid_argument("wrong vector size");
+		}
+		int i = 0;
+	#if MAT_SIMD >= MAT_SIMD_SSE
+		for (; i + PACK_SIZE <= a.getSize(); i += PACK_SIZE) {
+			Pack r = mul(load(a.getX() + i), load(b.getX() + i));
+			r = add(r, mul(load(a.getY() + i), load(b.getY() + i)));
+			r = add(r, mul(load(a.getZ() + i), load(b.getZ() + i)));
+			storeu(out + i, r);
+		}
+	#endif
+		for (; i < a.getSize(); i++) {
+			out[i] = a.getX()[i] * b.getX()[i] + a.getY()[i] * b.getY()[i] + a.getZ()[i] * b.getZ()[i];
+		}
+	}
+
+	void cross(const Vec3Array &a, const Vec3Array &b, Vec3Array &out) {
+		if (a.getSize() != b.getSize()) {
+			throw std::invalid_argument("wrong vector size");
+		}
+		out.resize(a.getSize());
+		int i = 0;
+	#if MAT_SIMD >= MAT_SIMD_SSE
+		for (; i + PACK_SIZE <= a.getSize(); i += PACK_SIZE) {
+			Pack ax = load(a.getX() + i), ay = load(a.getY() + i), az = load(a.getZ() + i);
+			Pack bx = load(b.getX() + i), by = load(b.getY() + i), bz = load(b.getZ() + i);
+			store(out.getX() + i, sub(mul(ay, bz), mul(az, by)));
+			store(out.getY() + i, sub(mul(az, bx), mul(ax, bz)));
+			store(out.getZ() + i, sub(mul(ax, by), mul(ay, bx)));
+		}
+	#endif
+		for (; i < a.getSize(); i++) {
+			float ax = a.getX()[i], ay = a.getY()[i], az = a.getZ()[i];
+			float bx = b.getX()[i], by = b.getY()[i], bz = b.getZ()[i];
+			out.getX()[i] = ay * bz - az * by;
+			out.getY()[i] = az * bx - ax * bz;
+			out.getZ()[i] = ax * by - ay * bx;
+		}
+	}
+
+	void lerpBatch(const float *a, const float *b, float step, float *out, int count) {
+		int i = 0;
+	#if MAT_SIMD >= MAT_SIMD_SSE
+		Pack s = set1(step);
+		for (; i + PACK_SIZE <= count; i += PACK_SIZE) {
+			Pack pa = loadu(a + i);
+			storeu(out + i, add(pa, mul(sub(loadu(b + i), pa), s)));
+		}
+	#endif
+		for (; i < count; i++) {
+			out[i] = a[i] + (b[i] - a[i]) * step;
+		}
+	}
+
+	void lerpBatch(const float *a, const float *b, const float *steps, float *out, int count) {
+		int i = 0;
+	#if MAT_SIMD >= MAT_SIMD_SSE
+		for (; i + PACK_SIZE <= count; i += PACK_SIZE) {
+			Pack pa = loadu(a + i);
+			storeu(out + i, add(pa, mul(sub(loadu(b + i), pa), loadu(steps + i))));
+		}
+	#endif
+		for (; i < count; i++) {
+			out[i] = a[i] + (b[i] - a[i]) * steps[i];
+		}
+	}
+}
@@ -38,7 +38,7 @@ aiMatrix4x4 mat4ToAi(mat::Mat4 mat)
                        mat[3][0],mat[3][1],mat[3][2],mat[3][3]);
 }
 
-mat::Mat4 aiToMat4(aiMatrix4x4& in_mat)
+mat::Mat4 aiToMat4(const aiMatrix4x4& in_mat)
 {
     mat::Mat4 tmp;
     tmp[0][0] = in_mat.a1;
@@ -67,13 +67,8 @@ mat::Mat4 aiToMat4(aiMatrix4x4& in_mat)
 aiQuaternion quatToAi(mat::Quaternion quat) {
     return aiQuaternion(quat.w, quat.vec.x, quat.vec.y, quat.vec.z);
 }
-mat::Quaternion aiToQuat(aiQuaternion& in_quat) {
-    mat::Quaternion q = mat::Quaternion();
-    q.w = in_quat.w;
-    q.vec.x = in_quat.x;
-    q.vec.y = in_quat.y;
-    q.vec.z = in_quat.z;
-    return q;
+mat::Quaternion aiToQuat(const aiQuaternion& in_quat) {
+    return mat::Quaternion(in_quat.w, in_quat.x, in_quat.y, in_quat.z);
 }
 
 mat::Vec3 aiToVec3(aiVector3D v) {
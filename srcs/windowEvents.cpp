@@ -118,6 +118,12 @@ void	keyCb(GLFWwindow *window, int key, int scancode, int action, int mods)
 		}
 	}
 
+	if (key == GLFW_KEY_L && action == GLFW_PRESS) {
+		for (auto it = winU->models->begin(); it != winU->models->end(); it++) {
+			(*it)->loadNextAdditiveAnimation();
+		}
+	}
+
 	if (key == GLFW_KEY_P && action == GLFW_PRESS) {
 		togglePause(window);
 	}